@@ -25,11 +25,99 @@ extern "C" {
 #define PCD8544_DEBUG           /* Activate screen debug mode - Thorough printing in the terminal */
 #define PCD8544_DMA_ACTIVE      /* Enable SPI transmissions via DMA */
 #define SPI_TIMEOUT 10          /* Timeout for polling SPI - 10ms is enough */
+#define PCD8544_CLIP_DEPTH      4       /* Number of clip rectangles that can be pushed */
 
 /* Reference values for the user */
 #define PCD8544_BIAS_DEFAULT            0x00
 #define PCD8544_VOP_DEFAULT             0x50
 
+/* Raster operations - How drawn pixels (source) are combined with the buffer (destination).
+ * For shapes, the source is black(true) or white(false). Drawing black with OR sets pixels,
+ * with XOR inverts them and with ANDNOT clears them. Drawing white solid only has an effect with
+ * COPY and AND, which clears the pixels under it. With a stipple pattern, the source of a filled
+ * shape is the pattern when drawing black and the inverted pattern when drawing white. */
+#define PCD8544_ROP_COPY                0x00        /* Overwrite the destination (default) */
+#define PCD8544_ROP_OR                  0x01        /* Set where the source is black */
+#define PCD8544_ROP_XOR                 0x02        /* Invert where the source is black */
+#define PCD8544_ROP_ANDNOT              0x03        /* Clear where the source is black */
+#define PCD8544_ROP_AND                 0x04        /* Keep only where the source is black */
+
+/* Polygon fill rules */
+#define PCD8544_FILL_EVENODD            0x00
+#define PCD8544_FILL_NONZERO            0x01
+
+/* Predefined hatch patterns, see PCD8544_hatch() */
+#define PCD8544_HATCH_HORIZONTAL        0x00
+#define PCD8544_HATCH_VERTICAL          0x01
+#define PCD8544_HATCH_DIAGONAL          0x02        /* Lines going up to the right */
+#define PCD8544_HATCH_BACK_DIAGONAL     0x03        /* Lines going down to the right */
+#define PCD8544_HATCH_CROSS             0x04
+#define PCD8544_HATCH_DIAGONAL_CROSS    0x05
+
+/* Exposed area of PCD8544_scroll() */
+#define PCD8544_SCROLL_KEEP             0x00        /* Left as it was */
+#define PCD8544_SCROLL_WHITE            0x01
+#define PCD8544_SCROLL_BLACK            0x02
+
+/* Transforms of PCD8544_transform() - The transpose (swap x and y) is applied before the mirrors */
+#define PCD8544_MIRROR_X                0x01        /* Left to right */
+#define PCD8544_MIRROR_Y                0x02        /* Top to bottom */
+#define PCD8544_TRANSPOSE               0x04
+#define PCD8544_ROTATE_90               (PCD8544_TRANSPOSE | PCD8544_MIRROR_X)      /* Clockwise */
+#define PCD8544_ROTATE_180              (PCD8544_MIRROR_X | PCD8544_MIRROR_Y)
+#define PCD8544_ROTATE_270              (PCD8544_TRANSPOSE | PCD8544_MIRROR_Y)
+
+/* Run-length encoded bitmaps - The bank bytes of a bitmap (as in PCD8544_draw_bitmap()) in packets.
+ * Header 0x00-0x7f: (header + 1) literal bytes follow. Header 0x80-0xff: the next byte is repeated
+ * (header - 0x80 + 2) times. Packets can continue from one bank into the next. */
+#define PCD8544_RLE_RUN                 0x80
+
+/* Number of grey levels of PCD8544_pattern_grey() - 0 is white and 64 is black */
+#define PCD8544_GREY_LEVELS             64
+
+/* Rectangle with inclusive coordinates */
+typedef struct pcd_8544_rect_struct
+{
+    uint8_t x0, x1, y0, y1;
+}pcd_8544_rect_t;
+
+/* Size in bytes of a surface buffer - Banks of 8 rows, one byte per column */
+#define PCD8544_SURFACE_SZ(width, height)   ((width) * (((height) + 7) / 8))
+
+/* Offscreen surface - Same layout as the display buffer, stride bytes per bank */
+typedef struct pcd_8544_surface_struct
+{
+    uint8_t *buffer;
+    uint8_t width, height;      /* Size in pixels */
+    uint16_t stride;            /* Bytes per bank, at least width */
+}pcd_8544_surface_t;
+
+/* Temporal greyscale - Two bitplanes (PCD8544_BUFFER_SZ bytes each) sent in turn, the MSB plane twice per cycle.
+ * A pixel is black for (2 * msb + lsb) of the 3 frames of a cycle, which the panel shows as 4 grey levels.
+ * Needs PCD8544_DMA_ACTIVE, the frames are sent from a timer interrupt. */
+#define PCD8544_GREY_CYCLE              3           /* Frames per cycle */
+
+typedef struct pcd_8544_grey_struct
+{
+    const uint8_t *lsb, *msb;                   /* Planes being shown */
+    const uint8_t * volatile next_lsb;          /* Planes to show from the next cycle, see PCD8544_grey_show() */
+    const uint8_t * volatile next_msb;
+    volatile bool pending;
+    volatile uint8_t frame;                     /* Frame of the cycle */
+    volatile uint32_t frames, dropped;          /* Frames sent and ticks that found the bus busy */
+}pcd_8544_grey_t;
+
+/* Drawing state - Saved and reset by code that draws the screen on its own, see PCD8544_state_save() */
+typedef struct pcd_8544_state_struct
+{
+    pcd_8544_surface_t target;
+    pcd_8544_rect_t clip;
+    pcd_8544_rect_t clip_stack[PCD8544_CLIP_DEPTH];
+    uint8_t clip_depth;
+    uint8_t rop;
+    const uint8_t *pattern;
+}pcd_8544_state_t;
+
 /* Structure used for the GPIO definitions */
 typedef struct pcd_8544_base_struct
 {
@@ -47,16 +135,58 @@ typedef struct pcd_8544_base_struct
     /* Cursor position and chosen font */
     uint8_t x_pos, y_pos;
 
+    /* Raster operation used for drawing */
+    uint8_t rop;
+
+    /* Stipple pattern of the filled shapes - One byte per column (x mod 8), NULL for solid fills */
+    const uint8_t *pattern;
+
+    /* Active clip rectangle and the stack of the pushed ones */
+    pcd_8544_rect_t clip;
+    pcd_8544_rect_t clip_stack[PCD8544_CLIP_DEPTH];
+    uint8_t clip_depth;
+
+    /* Draw target - The display buffer or an offscreen surface */
+    pcd_8544_surface_t target;
+
+    /* Temporal greyscale scheduler, NULL when it is stopped */
+    pcd_8544_grey_t * volatile grey;
+
 #ifdef PCD8544_DMA_ACTIVE
     /* Flag for DMA transfer status - User must not write this field during operation !! */
     volatile bool dma_transfer;
 #endif
 }pcd_8544_t;
 
+/* Edge table entry for the polygon filler - The caller provides one per polygon vertex */
+typedef struct pcd_8544_edge_struct
+{
+    int32_t x, dx;          /* Scanline crossing and slope (16.16 fixed point) */
+    uint8_t y_top, y_bot;   /* First scanline and one past the last scanline */
+    int8_t  dir;            /* Winding direction, +1 for downwards edges */
+    uint8_t next;           /* Next edge in the active edge list */
+}pcd_8544_edge_t;
+
+/* Stack entry for the flood filler - Vertical span of a column */
+typedef struct pcd_8544_span_struct
+{
+    uint8_t x, y0, y1;      /* Column and its (inclusive) row range */
+    int8_t  dir;            /* Search direction, -1 left and +1 right */
+}pcd_8544_span_t;
+
 /* Initializers */
 bool PCD8544_init(pcd_8544_t *init);
 pcd_8544_t *PCD8544_handle_swap(pcd_8544_t *new);
 bool PCD8544_refresh();
+bool PCD8544_refresh_region(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+bool PCD8544_refresh_rle(const uint8_t *data);
+bool PCD8544_refresh_view(const pcd_8544_surface_t *canvas, uint8_t x, uint8_t y);
+
+/* Temporal greyscale */
+bool PCD8544_grey_start(pcd_8544_grey_t *grey, const uint8_t *lsb, const uint8_t *msb);
+void PCD8544_grey_show(const uint8_t *lsb, const uint8_t *msb);
+void PCD8544_grey_tick();
+void PCD8544_grey_stop();
 
 /* Utilities */
 void PCD8544_fill(bool black);
@@ -64,6 +194,14 @@ bool PCD8544_invert(bool invert);
 bool PCD8544_sleep_mode(bool enable);
 bool PCD8544_contrast(uint8_t contrast);
 bool PCD8544_bias(uint8_t bias);
+uint8_t PCD8544_rop(uint8_t rop);
+bool PCD8544_clip_push(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+bool PCD8544_clip_pop();
+void PCD8544_state_save(pcd_8544_state_t *state);
+void PCD8544_state_restore(const pcd_8544_state_t *state);
+const uint8_t *PCD8544_pattern(const uint8_t *pattern);
+const uint8_t *PCD8544_hatch(uint8_t style);
+void PCD8544_pattern_grey(uint8_t level, uint8_t *pattern);
 
 /* Lines and pixels */
 void PCD8544_set_pixel(uint8_t x, uint8_t y, bool color);
@@ -74,20 +212,44 @@ void PCD8544_draw_vline(uint8_t x, uint8_t y, uint8_t len, bool color);
 
 /* Shape drawing */
 void PCD8544_draw_rectangle(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color, bool fill);
+void PCD8544_invert_rect(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+void PCD8544_scroll(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, int8_t dx, int8_t dy, uint8_t exposed);
 void PCD8544_draw_triangle(uint8_t x0, uint8_t x1, uint8_t x2, uint8_t y0, uint8_t y1, uint8_t y2, bool color);
 void PCD8544_draw_fill_triangle(uint8_t x0, uint8_t x1, uint8_t x2, uint8_t y0, uint8_t y1, uint8_t y2, bool color);
 void PCD8544_draw_circle(uint8_t x, uint8_t y, uint8_t r, bool color);
 void PCD8544_draw_fill_circle(uint8_t x0, uint8_t y0, uint8_t r, bool color);
-void PCD8544_draw_round_rect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, bool color, bool fill);
+void PCD8544_draw_round_rect(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, uint8_t r, bool color, bool fill);
+void PCD8544_draw_fill_polygon(const uint8_t *x, const uint8_t *y, uint8_t num, uint8_t rule, pcd_8544_edge_t *edges, bool color);
+bool PCD8544_flood_fill(uint8_t x, uint8_t y, bool color, pcd_8544_span_t *stack, uint16_t stack_sz);
 
 /* Bitmaps */
 void PCD8544_draw_bitmap(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y);
 void PCD8544_draw_bitmap_opt8(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y);
+void PCD8544_draw_sprite(const uint8_t *bitmap, const uint8_t *mask, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y);
+void PCD8544_draw_sprite_key(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y, bool transparent);
+
+/* Bitmaps with signed origins - Partially off-screen on any side */
+void PCD8544_draw_bitmap_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y);
+void PCD8544_draw_bitmap_opt8_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y);
+void PCD8544_draw_sprite_s(const uint8_t *bitmap, const uint8_t *mask, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y);
+void PCD8544_draw_sprite_key_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, bool transparent);
+void PCD8544_draw_bitmap_scaled(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, uint8_t scale);
+void PCD8544_draw_bitmap_resized(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, uint8_t out_x, uint8_t out_y);
+void PCD8544_draw_bitmap_rle(const uint8_t *data, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y);
+void PCD8544_draw_bitmap_rows(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, bool lsb_first);
+void PCD8544_transform_bitmap(const uint8_t *bitmap, uint8_t *out, uint8_t len_x, uint8_t len_y, uint8_t op);
+
+/* Offscreen surfaces */
+void PCD8544_surface_init(pcd_8544_surface_t *surface, uint8_t *buffer, uint8_t width, uint8_t height);
+bool PCD8544_target(const pcd_8544_surface_t *surface);
+void PCD8544_blit_surface(const pcd_8544_surface_t *src, uint8_t sx0, uint8_t sx1, uint8_t sy0, uint8_t sy1, int16_t x0, int16_t y0);
+bool PCD8544_transform(const pcd_8544_surface_t *src, const pcd_8544_surface_t *dst, uint8_t op);
 
 /* Text */
 void PCD8544_coord(uint8_t x, uint8_t p);
 void PCD8544_print_str(const char *str, uint8_t option, bool invert);
 void PCD8544_print_fstr(const char *str, uint8_t option, uint8_t x, uint8_t y, bool invert);
+void PCD8544_print_fstr_scaled(const char *str, uint8_t option, uint8_t x, uint8_t y, uint8_t scale, bool invert);
 
 #ifdef __cplusplus
 }
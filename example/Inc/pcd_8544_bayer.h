@@ -0,0 +1,25 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_BAYER_H
+#define __PCD_8544_BAYER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes */
+#include <stdint.h>
+
+/* Ordered dither (Bayer) matrix, indexed [y][x] - Levels from 0 to 63, a pixel is set below its level.
+ * Apart from pcd_8544.h like the fonts, so that host tools dither like the library */
+extern const uint8_t bayer_8x8[8][8];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_BAYER_H */
@@ -0,0 +1,39 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_DAMAGE_H
+#define __PCD_8544_DAMAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes */
+#include <pcd_8544.h>
+
+/* Damage parameters */
+#define PCD8544_DAMAGE_BANKS        (PCD8544_HEIGHT / 8)        /* Number of banks tracked */
+
+/* Damage - The changed columns of each bank, x0 > x1 if the bank is intact.
+ * It is tracked bank-wise, like the refresh, so a bank is sent as one region. */
+typedef struct pcd_8544_damage_struct
+{
+    uint8_t x0[PCD8544_DAMAGE_BANKS], x1[PCD8544_DAMAGE_BANKS];
+}pcd_8544_damage_t;
+
+/* Redraws the damaged columns of a bank in the display buffer, clipped to them. See PCD8544_damage_flush() */
+typedef void (*pcd_8544_redraw_t)(void *ctx, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+
+/* Damage tracking */
+void PCD8544_damage_clear(pcd_8544_damage_t *damage);
+void PCD8544_damage_add(pcd_8544_damage_t *damage, int16_t x0, int16_t x1, int16_t y0, int16_t y1);
+bool PCD8544_damage_flush(pcd_8544_damage_t *damage, pcd_8544_redraw_t redraw, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_DAMAGE_H */
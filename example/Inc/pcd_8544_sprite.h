@@ -0,0 +1,63 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_SPRITE_H
+#define __PCD_8544_SPRITE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes */
+#include <pcd_8544_damage.h>
+
+/* Pool parameters */
+#define PCD8544_SPRITE_POOL         8                           /* Number of sprites in a pool */
+
+/* Sprite - Frames and masks are bitmaps of len_x * len_y, in the display's layout */
+typedef struct pcd_8544_sprite_struct
+{
+    const uint8_t * const *frames;      /* Frame table */
+    const uint8_t * const *masks;       /* Mask table (one per frame), NULL if white pixels are transparent */
+    uint8_t num_frames, frame;          /* Number of frames and current frame */
+    uint8_t len_x, len_y;               /* Sprite size */
+    int16_t x, y;                       /* Position, can be partially off-screen */
+    uint8_t z;                          /* Z-order, higher is drawn on top */
+    bool visible, used;
+
+    /* State at the last update - Used for damage tracking */
+    int16_t drawn_x, drawn_y;
+    uint8_t drawn_frame, drawn_z;
+    bool drawn_visible;
+}pcd_8544_sprite_t;
+
+/* Sprite pool - Sprites are drawn over the background, only in the damaged parts of each bank */
+typedef struct pcd_8544_sprite_pool_struct
+{
+    pcd_8544_sprite_t sprites[PCD8544_SPRITE_POOL];
+    const uint8_t *background;          /* Full screen bitmap (PCD8544_BUFFER_SZ bytes), NULL for white */
+    pcd_8544_damage_t damage;
+}pcd_8544_sprite_pool_t;
+
+/* Pool management */
+void PCD8544_sprite_init(pcd_8544_sprite_pool_t *pool, const uint8_t *background);
+pcd_8544_sprite_t *PCD8544_sprite_add(pcd_8544_sprite_pool_t *pool, const uint8_t * const *frames, const uint8_t * const *masks,
+                                      uint8_t num_frames, uint8_t len_x, uint8_t len_y, uint8_t z);
+void PCD8544_sprite_remove(pcd_8544_sprite_t *sprite);
+void PCD8544_sprite_invalidate(pcd_8544_sprite_pool_t *pool, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+bool PCD8544_sprite_update(pcd_8544_sprite_pool_t *pool);
+
+/* Sprite state */
+void PCD8544_sprite_move(pcd_8544_sprite_t *sprite, int16_t x, int16_t y);
+void PCD8544_sprite_frame(pcd_8544_sprite_t *sprite, uint8_t frame);
+void PCD8544_sprite_next_frame(pcd_8544_sprite_t *sprite);
+void PCD8544_sprite_show(pcd_8544_sprite_t *sprite, bool visible);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_SPRITE_H */
@@ -4,8 +4,14 @@
   */
 
 #include <pcd_8544.h> /* NOKIA 5110 - PCD8544 */
+#include <pcd_8544_sprite.h>
+#include <pcd_8544_tilemap.h>
+#include <pcd_8544_anim.h>
+#include <pcd_8544_dither.h>
+#include <pcd_8544_layer.h>
 #include "main.h"
 #include <stdio.h>
+#include <string.h>
 
 /* Private variables */
 SPI_HandleTypeDef hspi2;
@@ -37,6 +43,13 @@ static void test_lcd_basic();
 static void test_lcd_simple_patterns();
 static void test_lcd_intermediate_patterns();
 static void test_lcd_bitmaps();
+static void test_lcd_sprites();
+static void test_lcd_tilemap();
+static void test_lcd_animation();
+static void test_lcd_surfaces();
+static void test_lcd_canvas();
+static void test_lcd_grey();
+static void test_lcd_layers();
 static void test_lcd_text();
 
 /**
@@ -173,6 +186,27 @@ void draw_examples(void)
     printf("\n\n************BITMAP TESTS************\n");
     test_lcd_bitmaps();
 
+    printf("\n\n************SPRITE TESTS************\n");
+    test_lcd_sprites();
+
+    printf("\n\n************TILEMAP TESTS************\n");
+    test_lcd_tilemap();
+
+    printf("\n\n************ANIMATION TESTS************\n");
+    test_lcd_animation();
+
+    printf("\n\n************SURFACE TESTS************\n");
+    test_lcd_surfaces();
+
+    printf("\n\n************CANVAS TESTS************\n");
+    test_lcd_canvas();
+
+    printf("\n\n************GREYSCALE TESTS************\n");
+    test_lcd_grey();
+
+    printf("\n\n************LAYER TESTS************\n");
+    test_lcd_layers();
+
     printf("\n\n************TEXT TESTS************\n");
     test_lcd_text();
 }
@@ -327,6 +361,8 @@ static void test_lcd_simple_patterns()
  */
 static void test_lcd_intermediate_patterns()
 {
+    uint32_t time;
+
     /* Clear screen */
     SCREEN_DELAY_FILL(3000, false);
 
@@ -387,10 +423,127 @@ static void test_lcd_intermediate_patterns()
 
 
     /* Draw rounded rectangles */
-    PCD8544_draw_round_rect(10, 40, 10, 40, true, false);
-    PCD8544_draw_round_rect(20, 30, 20, 30, true, false);
-    PCD8544_draw_round_rect(55, 65, 25, 35, true, true);
-    if(PCD8544_refresh()) printf("\t[4]Drawing rounded rectangles:OK\n");
+    PCD8544_draw_round_rect(10, 40, 10, 40, 6, true, false);
+    PCD8544_draw_round_rect(20, 30, 20, 30, 2, true, false);
+    PCD8544_draw_round_rect(55, 65, 25, 35, 3, true, true);
+    START_TIMER();
+    PCD8544_draw_round_rect(45, 80, 2, 20, 8, true, true);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[4]Drawing rounded rectangles - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Draw filled polygons - Same star with both fill rules */
+    pcd_8544_edge_t edges[5];
+    const uint8_t star_x[5] = {20, 32, 0, 40, 8};
+    const uint8_t star_y[5] = {2, 44, 16, 16, 44};
+    const uint8_t star2_x[5] = {62, 74, 42, 82, 50};
+    PCD8544_draw_fill_polygon(star_x, star_y, 5, PCD8544_FILL_EVENODD, edges, true);
+    PCD8544_draw_fill_polygon(star2_x, star_y, 5, PCD8544_FILL_NONZERO, edges, true);
+    if(PCD8544_refresh()) printf("\t[5]Drawing filled polygons:OK\n");
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Flood fill outlines drawn with the other primitives */
+    pcd_8544_span_t fill_stack[32];
+    PCD8544_draw_circle(20, 24, 15, true);
+    PCD8544_draw_triangle(45, 80, 62, 40, 40, 5, true);
+    START_TIMER();
+    PCD8544_flood_fill(20, 24, true, fill_stack, 32);
+    PCD8544_flood_fill(62, 30, true, fill_stack, 32);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[6]Flood filling outlines - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* XOR raster operation - Rubber band box over a pattern, erased by drawing it again */
+    for(uint8_t i = 0; i < PCD8544_WIDTH; i += 4) PCD8544_draw_vline(i, 0, PCD8544_HEIGHT, true);
+    PCD8544_rop(PCD8544_ROP_XOR);
+    for(uint8_t i = 0; i < 20; i += 2)
+    {
+        PCD8544_draw_rectangle(10, 30 + i, 5, 20 + i, true, false);
+        PCD8544_refresh();
+        HAL_Delay(200);
+        PCD8544_draw_rectangle(10, 30 + i, 5, 20 + i, true, false);
+    }
+    PCD8544_rop(PCD8544_ROP_COPY);
+    if(PCD8544_refresh()) printf("\t[7]XOR rubber band box:OK\n");
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Pattern fills - Grey ramp with the ordered dither levels and the predefined hatches */
+    uint8_t grey[8];
+    START_TIMER();
+    for(uint8_t i = 0; i < 8; i++)
+    {
+        PCD8544_pattern_grey(i * 9, grey);
+        PCD8544_pattern(grey);
+        PCD8544_draw_rectangle(i * 10, i * 10 + 9, 0, 23, true, true);
+    }
+    time = GET_TIMER();
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        PCD8544_pattern(PCD8544_hatch(i));
+        PCD8544_draw_fill_circle(7 + i * 14, 35, 6, true);
+    }
+    PCD8544_pattern(NULL);
+    if(PCD8544_refresh()) printf("\t[8]Pattern fills - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Word-wide kernels - Region inversion against a plain byte loop over the same banks */
+    uint32_t time_bytes;
+    PCD8544_draw_fill_circle(42, 24, 20, true);
+    START_TIMER();
+    for(uint8_t j = 0; j < 48; j++) PCD8544_draw_hline(0, j, PCD8544_WIDTH, j & 0x01);
+    time = GET_TIMER();
+    printf("\t[9]Hlines (48x84) - Time:%ld\n", time);
+
+    START_TIMER();
+    PCD8544_invert_rect(3, 80, 5, 42);
+    time = GET_TIMER();
+    PCD8544_refresh();
+    HAL_Delay(1000);
+    START_TIMER();
+    for(uint8_t bank = 0; bank < 6; bank++)
+    {
+        uint8_t mask = (bank == 0) ? 0xe0 : (bank == 5) ? 0x07 : 0xff;
+        for(uint8_t i = 3; i <= 80; i++) pcd8544_buffer[bank * PCD8544_WIDTH + i] ^= mask;
+    }
+    time_bytes = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[10]Region invert - Time:%ld (byte loop:%ld)\n", time, time_bytes);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Scrolling chart - The plot moves left by one column, only the new sample is drawn */
+    uint32_t max_time = 0;
+    uint8_t sample = 20;
+    PCD8544_draw_rectangle(0, PCD8544_WIDTH - 1, 0, PCD8544_HEIGHT - 1, true, false);
+    for(uint16_t i = 0; i < 200; i++)
+    {
+        sample += (HAL_GetTick() & 0x04) ? 2 : -2;
+        if(sample < 3 || sample > 44) sample = 24;
+
+        START_TIMER();
+        PCD8544_scroll(1, PCD8544_WIDTH - 2, 1, PCD8544_HEIGHT - 2, -1, 0, PCD8544_SCROLL_WHITE);
+        time = GET_TIMER();
+        if(time > max_time) max_time = time;
+
+        PCD8544_set_pixel(PCD8544_WIDTH - 2, sample, true);
+        PCD8544_refresh();
+        HAL_Delay(20);
+    }
+    printf("\t[11]Scrolling chart - Worst scroll time:%ld\n", max_time);
+
+    /* Log - Text moves up by a line */
+    for(uint8_t i = 0; i < 12; i++)
+    {
+        PCD8544_scroll(0, PCD8544_WIDTH - 1, 0, PCD8544_HEIGHT - 1, 0, -8, PCD8544_SCROLL_WHITE);
+        PCD8544_print_fstr(i & 0x01 ? "Log line odd" : "Log line even", SMALL_FONT, 0, 40, false);
+        PCD8544_refresh();
+        HAL_Delay(250);
+    }
+    printf("\t[12]Scrolling log\n");
     SCREEN_DELAY_FILL(3000, false);
 
 }
@@ -481,6 +634,53 @@ static void test_lcd_bitmaps()
         0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
     };
 
+    /* The same bitmaps, run-length encoded (233 and 362 bytes instead of 504) */
+    const uint8_t elegant_bitmap_rle[] =
+    {
+        0xAD, 0xFF, 0x9D, 0x7F, 0x88, 0xFF, 0x82, 0x0F, 0x80, 0x8F, 0x81, 0x0F, 0x00, 0x3F, 0x9E, 0xFF,
+        0x02, 0x01, 0x00, 0xE0, 0x80, 0xF0, 0x00, 0xE0, 0x8E, 0x00, 0x00, 0xE0, 0x80, 0xF0, 0x00, 0xE0,
+        0x85, 0x00, 0x87, 0xFF, 0x81, 0x00, 0x81, 0x3F, 0x0E, 0x1F, 0x0E, 0x00, 0x80, 0xE0, 0x7F, 0x0F,
+        0x07, 0xC3, 0xE3, 0xE1, 0xE3, 0x03, 0x07, 0x1F, 0x80, 0xFF, 0x80, 0x03, 0x04, 0x83, 0xE3, 0xE1,
+        0xF3, 0xFF, 0x81, 0x03, 0x05, 0xC3, 0xE3, 0xE1, 0x83, 0x03, 0x07, 0x81, 0xFF, 0x80, 0x00, 0x82,
+        0xFF, 0x80, 0x3C, 0x80, 0xFC, 0x01, 0xF8, 0xE0, 0x82, 0xFC, 0x80, 0x00, 0x81, 0xFC, 0x00, 0xF8,
+        0x81, 0xFF, 0x00, 0xFD, 0x80, 0x3C, 0x04, 0x7C, 0xFC, 0xF8, 0xE0, 0x00, 0x87, 0xFF, 0x81, 0x00,
+        0x84, 0xFE, 0x80, 0xFF, 0x03, 0xF0, 0x80, 0x00, 0x1F, 0x81, 0x3F, 0x02, 0x07, 0x00, 0xC0, 0x80,
+        0xFF, 0x80, 0x00, 0x83, 0xFF, 0x81, 0x00, 0x82, 0xFF, 0x80, 0x00, 0x81, 0xFF, 0x80, 0x00, 0x82,
+        0xFF, 0x80, 0x00, 0x82, 0xFF, 0x00, 0x3F, 0x81, 0xFF, 0x80, 0xC0, 0x86, 0xFF, 0x80, 0xC0, 0x00,
+        0xE0, 0x80, 0xFF, 0x01, 0x7F, 0x00, 0x87, 0xFF, 0x02, 0xFE, 0xFC, 0xFE, 0x88, 0xFF, 0x80, 0xFE,
+        0x81, 0xFC, 0x00, 0xFE, 0x82, 0xFF, 0x01, 0xFC, 0xFE, 0x83, 0xFF, 0x02, 0xFE, 0xFC, 0xFE, 0x82,
+        0xFF, 0x01, 0xFC, 0xFE, 0x81, 0xFF, 0x02, 0x80, 0x00, 0x01, 0x81, 0x03, 0x80, 0x00, 0x00, 0x01,
+        0x81, 0x03, 0x01, 0x00, 0x01, 0x82, 0x03, 0x00, 0x01, 0x80, 0x03, 0x00, 0x01, 0x86, 0x03, 0x00,
+        0x01, 0x80, 0x00, 0xB2, 0xFF, 0x9D, 0xFE, 0x84, 0xFF
+    };
+
+    const uint8_t bitmap2_rle[] =
+    {
+        0x80, 0xFF, 0x00, 0xDF, 0x89, 0xFF, 0x00, 0xEF, 0x85, 0xFF, 0x00, 0xEF, 0x84, 0xFF, 0x00, 0xDF,
+        0x88, 0xFF, 0x01, 0x7F, 0xFF, 0x80, 0xF7, 0x82, 0xFF, 0x00, 0xEF, 0x87, 0xFF, 0x00, 0xBF, 0x8A,
+        0xFF, 0x00, 0xEF, 0x84, 0xFF, 0x00, 0xF7, 0x8D, 0xFF, 0x02, 0xFB, 0xFF, 0x7F, 0x88, 0xFF, 0x00,
+        0x3F, 0x80, 0x1F, 0x00, 0x5F, 0x80, 0x1F, 0x01, 0x3F, 0xFF, 0x81, 0x1F, 0x00, 0xDF, 0x80, 0x1F,
+        0x01, 0x3F, 0xFF, 0x82, 0x1F, 0x81, 0xFF, 0x80, 0x1F, 0x80, 0xDF, 0x80, 0x1F, 0x80, 0xFF, 0x80,
+        0x1F, 0x80, 0xDF, 0x00, 0xFF, 0x80, 0xEF, 0x8C, 0xFF, 0x00, 0xEF, 0x83, 0xFF, 0x00, 0xFB, 0x84,
+        0xFF, 0x00, 0xDF, 0x8C, 0xFF, 0x80, 0xFB, 0x80, 0xFF, 0x07, 0xF3, 0xF2, 0xE2, 0xE6, 0xE4, 0xE0,
+        0xF1, 0xFF, 0x81, 0xE0, 0x81, 0xFC, 0x02, 0xFE, 0xE7, 0xE0, 0x80, 0xF2, 0x01, 0xE0, 0xE4, 0x80,
+        0xFF, 0x01, 0xF0, 0xE0, 0x80, 0xE7, 0x01, 0xE1, 0xF1, 0x80, 0xFF, 0x80, 0xE0, 0x80, 0xE6, 0x00,
+        0xEF, 0x80, 0xFF, 0x00, 0xF7, 0x84, 0xFF, 0x00, 0xFD, 0x95, 0xFF, 0x00, 0xF7, 0x83, 0xFF, 0x81,
+        0x01, 0x80, 0xFF, 0x80, 0x01, 0x00, 0xC3, 0x80, 0x01, 0x01, 0xFF, 0xF9, 0x80, 0x01, 0x00, 0x7F,
+        0x80, 0x01, 0x02, 0xF9, 0x7F, 0x01, 0x80, 0x21, 0x01, 0x01, 0x0F, 0x80, 0xFF, 0x80, 0x01, 0x80,
+        0x7D, 0x80, 0x01, 0x80, 0xFF, 0x80, 0x01, 0x80, 0x6D, 0x80, 0xFF, 0x80, 0x01, 0x00, 0xED, 0x80,
+        0x01, 0x80, 0xFF, 0x06, 0x31, 0x21, 0x65, 0x4D, 0x41, 0x11, 0x1F, 0x83, 0xFF, 0x00, 0xFE, 0x85,
+        0xFF, 0x00, 0xBF, 0x85, 0xFF, 0x00, 0xBF, 0x86, 0xFF, 0x00, 0x3E, 0x80, 0x0E, 0x01, 0x1F, 0x3F,
+        0x80, 0xFE, 0x00, 0xFF, 0x80, 0xFE, 0x03, 0x7E, 0x1F, 0x3F, 0x3E, 0x80, 0x1E, 0x01, 0x7F, 0xFF,
+        0x80, 0xFE, 0x05, 0xFF, 0x7F, 0xBE, 0x1E, 0x9F, 0x7F, 0x82, 0xFE, 0x01, 0x7E, 0x1E, 0x80, 0x3F,
+        0x01, 0x1E, 0x7E, 0x81, 0xFE, 0x05, 0xFF, 0x3E, 0x0E, 0x0F, 0x1E, 0x3E, 0x81, 0xFF, 0x05, 0xFE,
+        0x7E, 0x9E, 0x1E, 0xBE, 0x7F, 0x80, 0xFF, 0x00, 0xDF, 0x85, 0xFF, 0x00, 0xEF, 0x8B, 0xFF, 0x00,
+        0xEF, 0x83, 0xFF, 0x80, 0xF8, 0x02, 0xFC, 0xF8, 0xFA, 0x82, 0xFF, 0x07, 0xFC, 0xFE, 0xF8, 0xBC,
+        0xFE, 0xF8, 0xFA, 0xFC, 0x82, 0xFF, 0x00, 0xFD, 0x82, 0xFC, 0x81, 0xFF, 0x02, 0xFC, 0xFA, 0xF8,
+        0x80, 0xFE, 0x02, 0xF8, 0xFE, 0xFC, 0x81, 0xFF, 0x80, 0xF8, 0x00, 0xFC, 0x80, 0xF8, 0x82, 0xFF,
+        0x82, 0xFC, 0x00, 0xFD, 0x84, 0xFF, 0x00, 0xBF, 0x87, 0xFF
+    };
+
     /* Bitmap 1 test */
     START_TIMER();
     PCD8544_draw_bitmap_opt8(bitmap1, 0, 0, 8, 32);
@@ -516,6 +716,550 @@ static void test_lcd_bitmaps()
     ret = PCD8544_refresh();
     SCREEN_DELAY_FILL(3000, false);
     if(ret) printf("\t[4]Drawing space invaders bitmap with opt routine - Time:%ld\n", time);
+
+
+    /* Bitmap 1 test at unaligned rows - Banks are shifted, so it costs about the same as aligned */
+    START_TIMER();
+    for(uint8_t i = 0; i < 8; i++) PCD8544_draw_bitmap(bitmap1, i * 10, i * 2 + 1, 8, 32);
+    time = GET_TIMER();
+    ret = PCD8544_refresh();
+    SCREEN_DELAY_FILL(3000, false);
+    if(ret) printf("\t[5]Drawing simple bitmap at unaligned rows - Time:%ld\n", time);
+
+
+    /* Masked sprite - A ring moving over a pattern, without saving the background */
+    const uint8_t ring[8] = { 0x3c, 0x42, 0x81, 0x81, 0x81, 0x81, 0x42, 0x3c };
+    const uint8_t ring_mask[8] = { 0x3c, 0x7e, 0xff, 0xff, 0xff, 0xff, 0x7e, 0x3c };
+    for(uint8_t i = 0; i < 40; i++)
+    {
+        PCD8544_draw_bitmap_opt8(elegant_bitmap, 0, 0, 84, 48);
+        START_TIMER();
+        PCD8544_draw_sprite(ring, ring_mask, i * 2, i, 8, 8);
+        PCD8544_draw_sprite_key(ring, 76 - i * 2, i, 8, 8, false);
+        time = GET_TIMER();
+        PCD8544_refresh();
+        HAL_Delay(50);
+    }
+    printf("\t[6]Masked and transparent sprites - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Signed origins - The invaders slide in from the top left corner */
+    for(int16_t i = -48; i <= 0; i += 2)
+    {
+        PCD8544_fill(false);
+        PCD8544_draw_bitmap_s(bitmap2, i * 2, i, 84, 48);
+        PCD8544_refresh();
+        HAL_Delay(50);
+    }
+    printf("\t[7]Drawing bitmaps partially off-screen:OK\n");
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Row-major bitmap, MSB first like the Adafruit GFX assets - 16x16 heart */
+    const uint8_t heart[2 * 16] =
+    {
+        0x00, 0x00, 0x3c, 0x3c, 0x7e, 0x7e, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xfe,
+        0x3f, 0xfc, 0x1f, 0xf8, 0x0f, 0xf0, 0x07, 0xe0,
+        0x03, 0xc0, 0x01, 0x80, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    START_TIMER();
+    for(uint8_t i = 0; i < 5; i++) PCD8544_draw_bitmap_rows(heart, i * 17, i * 7, 16, 16, false);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[8]Row-major bitmaps - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Scaled bitmaps - The 8x8 ring at 2x, 3x and 4x, then stretched */
+    START_TIMER();
+    for(uint8_t i = 2; i <= 4; i++) PCD8544_draw_bitmap_scaled(ring, (i - 2) * 20, 0, 8, 8, i);
+    time = GET_TIMER();
+    PCD8544_draw_bitmap_resized(ring, 0, 34, 8, 8, 84, 14);
+    if(PCD8544_refresh()) printf("\t[9]Scaled bitmaps - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Run-length encoded bitmaps - Decoded straight into the buffer */
+    START_TIMER();
+    PCD8544_draw_bitmap_rle(elegant_bitmap_rle, 0, 0, 84, 48);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[10]Decoding RLE bitmap - Time:%ld (%ld bytes per 1000 cycles)\n",
+                                 time, (PCD8544_BUFFER_SZ * 1000) / time);
+    HAL_Delay(3000);
+
+    START_TIMER();
+    PCD8544_draw_bitmap_rle(bitmap2_rle, 0, 0, 84, 48);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[11]Decoding RLE bitmap 2 - Time:%ld (%ld bytes per 1000 cycles)\n",
+                                 time, (PCD8544_BUFFER_SZ * 1000) / time);
+    SCREEN_DELAY_FILL(3000, false);
+
+
+    /* Streamed splash screen - Decoded while it is sent, the buffer (now white) is not used */
+    START_TIMER();
+    ret = PCD8544_refresh_rle(elegant_bitmap_rle);
+    time = GET_TIMER();
+    if(ret) printf("\t[12]Streaming RLE frame to the display - Time:%ld\n", time);
+    HAL_Delay(3000);
+    PCD8544_refresh();
+    HAL_Delay(1000);
+
+    /* Dithering - A greyscale blob made 8 rows at a time, like a sensor delivers them, no frame copy */
+    static int16_t dither_error[PCD8544_DITHER_ERR_SZ(PCD8544_WIDTH)];
+    static uint8_t dither_bank[PCD8544_WIDTH], rows[8 * PCD8544_WIDTH];
+    const char *methods[4] = { "threshold", "Floyd-Steinberg", "Atkinson", "Bayer" };
+
+    for(uint8_t m = PCD8544_DITHER_THRESHOLD; m <= PCD8544_DITHER_BAYER; m++)
+    {
+        pcd_8544_dither_t d;
+        uint32_t total = 0;
+
+        PCD8544_dither_init(&d, m, 0, 0, PCD8544_WIDTH, dither_error, dither_bank);
+        for(uint8_t y0 = 0; y0 < PCD8544_HEIGHT; y0 += 8)
+        {
+            for(uint8_t y = 0; y < 8; y++)
+            {
+                for(uint8_t x = 0; x < PCD8544_WIDTH; x++)
+                {
+                    int32_t dx = x - 42, dy = y0 + y - 24, r2 = (dx * dx + dy * dy * 4) / 10;
+                    rows[y * PCD8544_WIDTH + x] = (r2 > 255) ? 255 : r2;
+                }
+            }
+
+            START_TIMER();
+            PCD8544_dither_rows(&d, rows, PCD8544_WIDTH, 8);
+            total += GET_TIMER();
+        }
+        PCD8544_dither_end(&d);
+
+        if(PCD8544_refresh()) printf("\t[%d]Dithering, %s - Time:%ld\n", 13 + m, methods[m], total);
+        SCREEN_DELAY_FILL(3000, false);
+    }
+}
+
+/* Animates sprites with the sprite engine - Only the damaged banks are redrawn and refreshed */
+static void test_lcd_sprites()
+{
+    static uint8_t background[PCD8544_BUFFER_SZ];
+    pcd_8544_sprite_pool_t pool;
+    uint32_t time, max_time = 0;
+
+    /* Status icons - Blinking bell and a battery that charges */
+    const uint8_t bell0[8] = { 0x40, 0x70, 0x7c, 0x7e, 0xfe, 0x7c, 0x70, 0x40 };
+    const uint8_t bell1[8] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    const uint8_t batt0[8] = { 0x7e, 0x42, 0x42, 0x42, 0x42, 0x42, 0x7e, 0x18 };
+    const uint8_t batt1[8] = { 0x7e, 0x7e, 0x42, 0x42, 0x42, 0x42, 0x7e, 0x18 };
+    const uint8_t batt2[8] = { 0x7e, 0x7e, 0x7e, 0x7e, 0x42, 0x42, 0x7e, 0x18 };
+    const uint8_t batt3[8] = { 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x18 };
+    const uint8_t *bell_frames[2] = { bell0, bell1 };
+    const uint8_t *batt_frames[4] = { batt0, batt1, batt2, batt3 };
+
+    /* Ball with a mask, so that its white inside covers the background */
+    const uint8_t ball[8] = { 0x3c, 0x42, 0x81, 0x81, 0x81, 0x81, 0x42, 0x3c };
+    const uint8_t ball_mask[8] = { 0x3c, 0x7e, 0xff, 0xff, 0xff, 0xff, 0x7e, 0x3c };
+    const uint8_t *ball_frames[1] = { ball };
+    const uint8_t *ball_masks[1] = { ball_mask };
+
+    /* Background - Drawn once with the library and kept aside */
+    PCD8544_fill(false);
+    PCD8544_draw_rectangle(0, 83, 10, 47, true, false);
+    PCD8544_pattern(PCD8544_hatch(PCD8544_HATCH_DIAGONAL));
+    PCD8544_draw_rectangle(1, 82, 11, 46, true, true);
+    PCD8544_pattern(NULL);
+    memcpy(background, pcd8544_buffer, sizeof(background));
+
+    PCD8544_sprite_init(&pool, background);
+    pcd_8544_sprite_t *bell = PCD8544_sprite_add(&pool, bell_frames, NULL, 2, 8, 8, 0);
+    pcd_8544_sprite_t *batt = PCD8544_sprite_add(&pool, batt_frames, NULL, 4, 8, 8, 0);
+    pcd_8544_sprite_t *ballp = PCD8544_sprite_add(&pool, ball_frames, ball_masks, 1, 8, 8, 1);
+    PCD8544_sprite_move(bell, 0, 0);
+    PCD8544_sprite_move(batt, 75, 0);
+
+    int16_t x = -8, y = 20, dx = 1, dy = 1;
+    for(uint16_t i = 0; i < 200; i++)
+    {
+        /* Icons animate slowly, the ball bounces in the box */
+        if(!(i & 0x0f)) PCD8544_sprite_next_frame(bell);
+        if(!(i & 0x1f)) PCD8544_sprite_next_frame(batt);
+
+        x += dx;
+        y += dy;
+        if(x >= 75 || (x <= 1 && dx < 0)) dx = -dx;
+        if(y >= 39 || y <= 11) dy = -dy;
+        PCD8544_sprite_move(ballp, x, y);
+
+        START_TIMER();
+        PCD8544_sprite_update(&pool);
+        time = GET_TIMER();
+        if(time > max_time && i) max_time = time;
+
+        HAL_Delay(30);
+    }
+    printf("\t[1]Sprite engine with damage tracking - Worst update time:%ld\n", max_time);
+    SCREEN_DELAY_FILL(3000, false);
+}
+
+/* Scrolls a tilemap - Aligned and pixel scrolling */
+static void test_lcd_tilemap()
+{
+    uint32_t time;
+    pcd_8544_tilemap_t tm;
+
+    /* Atlas - Empty, brick, ground and coin tiles */
+    const uint8_t atlas[4 * PCD8544_TILE_SZ] =
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xff, 0x91, 0x91, 0xff, 0x89, 0x89, 0x89, 0xff,
+        0xfe, 0xfd, 0xfe, 0xf5, 0xfa, 0xfd, 0xfa, 0xff,
+        0x00, 0x3c, 0x42, 0x5a, 0x5a, 0x42, 0x3c, 0x00,
+    };
+
+    /* Map - 32x6 tiles, a ground line with some bricks and coins on top */
+    uint8_t map[32 * 6];
+    for(uint8_t ty = 0; ty < 6; ty++)
+    {
+        for(uint8_t tx = 0; tx < 32; tx++)
+        {
+            uint8_t tile = 0;
+            if(ty == 5) tile = 2;
+            else if(ty == 4 && (tx % 7) == 3) tile = 1;
+            else if(ty == 3 && (tx % 7) == 3) tile = 3;
+            else if(ty == 1 && (tx % 5) == 0) tile = 3;
+            map[ty * 32 + tx] = tile;
+        }
+    }
+
+    PCD8544_tilemap_init(&tm, atlas, map, 32, 6);
+    tm.wrap = true;
+
+    /* Aligned scroll - Every tile is a plain copy */
+    PCD8544_tilemap_scroll(&tm, 0, 0);
+    START_TIMER();
+    PCD8544_tilemap_draw(&tm, 0, PCD8544_WIDTH - 1, 0, PCD8544_HEIGHT - 1);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[1]Drawing tilemap - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+    /* Pixel scroll - Horizontal and a little vertical bounce */
+    for(int16_t i = 0; i < 256; i++)
+    {
+        PCD8544_tilemap_scroll(&tm, i, (i & 0x08) ? 3 : 0);
+        START_TIMER();
+        PCD8544_tilemap_draw(&tm, 0, PCD8544_WIDTH - 1, 0, PCD8544_HEIGHT - 1);
+        time = GET_TIMER();
+        PCD8544_refresh();
+        HAL_Delay(20);
+    }
+    printf("\t[2]Scrolling tilemap - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+}
+
+/* Encodes an animation as keyframes and XOR deltas, then plays it - Only the changed columns are sent */
+static void test_lcd_animation()
+{
+    static uint8_t prev[PCD8544_BUFFER_SZ], data[2048];
+    static const uint8_t *frames[32];
+    pcd_8544_anim_t anim = { .frames = frames, .num_frames = 32, .keyframe_interval = 16 };
+    pcd_8544_player_t player;
+    uint32_t time, max_time = 0;
+    uint16_t size = 0;
+
+    /* Frames - A ball rolling over a static frame, drawn with the library and encoded one by one */
+    for(uint8_t i = 0; i < anim.num_frames; i++)
+    {
+        PCD8544_fill(false);
+        PCD8544_draw_rectangle(0, 83, 0, 47, true, false);
+        PCD8544_print_fstr("Delta", SMALL_FONT, 3, 3, false);
+        PCD8544_draw_fill_circle(8 + i * 2, 34, 6, true);
+
+        uint16_t n = PCD8544_anim_encode(PCD8544_anim_keyframe(&anim, i) ? NULL : prev, pcd8544_buffer, data + size, sizeof(data) - size);
+        if(!n)
+        {
+            printf("\t[1]Animation does not fit\n");
+            return;
+        }
+
+        frames[i] = data + size;
+        size += n;
+        memcpy(prev, pcd8544_buffer, sizeof(prev));
+    }
+    printf("\t[1]Encoded %d frames in %d bytes (raw %d bytes)\n", anim.num_frames, size, anim.num_frames * PCD8544_BUFFER_SZ);
+
+    /* Playback - The buffer must hold the previous frame, nothing else is drawn meanwhile */
+    PCD8544_player_init(&player, &anim, pcd8544_buffer, true);
+    for(uint16_t i = 0; i < 96; i++)
+    {
+        START_TIMER();
+        PCD8544_player_next(&player);
+        time = GET_TIMER();
+        if(time > max_time && !PCD8544_anim_keyframe(&anim, i % anim.num_frames)) max_time = time;
+
+        HAL_Delay(40);
+    }
+    printf("\t[2]Delta frames - Worst frame time:%ld\n", max_time);
+
+    /* Seeking - Decodes from the keyframe before the frame */
+    START_TIMER();
+    PCD8544_player_seek(&player, 31);
+    time = GET_TIMER();
+    printf("\t[3]Seek to the last frame - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+}
+
+/* Caches a widget in an offscreen surface and blits it around */
+static void test_lcd_surfaces()
+{
+    uint32_t time;
+    uint8_t widget_buf[PCD8544_SURFACE_SZ(40, 20)];
+    pcd_8544_surface_t widget;
+
+    /* Draw the widget once, offscreen */
+    PCD8544_surface_init(&widget, widget_buf, 40, 20);
+    PCD8544_target(&widget);
+    PCD8544_fill(false);
+    PCD8544_draw_round_rect(0, 39, 0, 19, 4, true, false);
+    PCD8544_print_fstr("OK", MEDIUM_FONT, 14, 7, false);
+    PCD8544_target(NULL);
+
+    /* Redraw the widget every time */
+    PCD8544_fill(false);
+    START_TIMER();
+    for(uint8_t i = 0; i < 4; i++)
+    {
+        PCD8544_draw_round_rect(i * 14, i * 14 + 39, i * 9, i * 9 + 19, 4, true, false);
+        PCD8544_print_fstr("OK", MEDIUM_FONT, i * 14 + 14, i * 9 + 7, false);
+    }
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[1]Drawing widgets - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+    /* Blit the cached widget instead */
+    START_TIMER();
+    for(uint8_t i = 0; i < 4; i++) PCD8544_blit_surface(&widget, 0, 39, 0, 19, i * 14, i * 9);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[2]Blitting cached widgets - Time:%ld\n", time);
+    SCREEN_DELAY_FILL(3000, false);
+
+    /* Raster operations - Overlapping widgets with XOR, then the lower half only */
+    PCD8544_fill(false);
+    PCD8544_rop(PCD8544_ROP_XOR);
+    for(uint8_t i = 0; i < 4; i++) PCD8544_blit_surface(&widget, 0, 39, 0, 19, i * 10, i * 6);
+    PCD8544_rop(PCD8544_ROP_COPY);
+    PCD8544_blit_surface(&widget, 0, 39, 10, 19, 44, 38);
+    if(PCD8544_refresh()) printf("\t[3]Blitting with XOR and partial regions\n");
+    SCREEN_DELAY_FILL(3000, false);
+
+    /* Portrait UI - Drawn on a 48x84 surface and rotated into the display buffer */
+    static uint8_t portrait_buf[PCD8544_SURFACE_SZ(48, 84)];
+    pcd_8544_surface_t portrait;
+
+    PCD8544_surface_init(&portrait, portrait_buf, 48, 84);
+    PCD8544_target(&portrait);
+    PCD8544_fill(false);
+    PCD8544_draw_round_rect(0, 47, 0, 83, 5, true, false);
+    PCD8544_print_fstr("Tall", MEDIUM_FONT, 12, 6, false);
+    PCD8544_draw_fill_circle(23, 45, 12, true);
+    PCD8544_draw_rectangle(8, 39, 66, 75, true, true);
+    PCD8544_target(NULL);
+
+    START_TIMER();
+    PCD8544_transform(&portrait, NULL, PCD8544_ROTATE_90);
+    time = GET_TIMER();
+    if(PCD8544_refresh()) printf("\t[4]Rotating a portrait frame - Time:%ld\n", time);
+    HAL_Delay(3000);
+
+    /* Upside down, in place */
+    pcd_8544_surface_t screen = { pcd8544_buffer, PCD8544_WIDTH, PCD8544_HEIGHT, PCD8544_WIDTH };
+    PCD8544_transform(&screen, &screen, PCD8544_ROTATE_180);
+    if(PCD8544_refresh()) printf("\t[5]Rotating the screen by 180 degrees\n");
+    SCREEN_DELAY_FILL(3000, false);
+}
+
+/* Pans the screen over a canvas 4 times its size */
+static void test_lcd_canvas()
+{
+    uint32_t time, max_time = 0;
+    static uint8_t canvas_buf[PCD8544_SURFACE_SZ(168, 96)];
+    pcd_8544_surface_t canvas;
+
+    /* Draw the whole canvas once - A grid of labeled circles */
+    PCD8544_surface_init(&canvas, canvas_buf, 168, 96);
+    PCD8544_target(&canvas);
+    PCD8544_fill(false);
+    PCD8544_draw_rectangle(0, 167, 0, 95, true, false);
+
+    for(uint8_t row = 0; row < 4; row++)
+    {
+        for(uint8_t col = 0; col < 6; col++)
+        {
+            char label[2] = { 'A' + row * 6 + col, '\0' };
+            PCD8544_draw_circle(col * 28 + 14, row * 24 + 12, 9, true);
+            PCD8544_print_fstr(label, SMALL_FONT, col * 28 + 13, row * 24 + 9, false);
+        }
+    }
+    PCD8544_target(NULL);
+
+    /* Aligned viewport - Sent straight out of the canvas */
+    START_TIMER();
+    bool ret = PCD8544_refresh_view(&canvas, 0, 0);
+    time = GET_TIMER();
+    if(ret) printf("\t[1]Aligned viewport - Time:%ld\n", time);
+    HAL_Delay(2000);
+
+    /* Pan diagonally, one pixel at a time */
+    for(uint8_t i = 0; i < 48; i++)
+    {
+        START_TIMER();
+        PCD8544_refresh_view(&canvas, i * 2, i);
+        time = GET_TIMER();
+        if(time > max_time) max_time = time;
+        HAL_Delay(40);
+    }
+    printf("\t[2]Panning the viewport - Worst time:%ld\n", max_time);
+    SCREEN_DELAY_FILL(3000, false);
+}
+
+/* Draws a filled rectangle of a grey level (0 white - 3 black) on a pair of planes */
+static void grey_rect(pcd_8544_surface_t *planes, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, uint8_t level)
+{
+    for(uint8_t i = 0; i < 2; i++)
+    {
+        PCD8544_target(&planes[i]);
+        PCD8544_draw_rectangle(x0, x1, y0, y1, (level >> i) & 0x01, true);
+    }
+    PCD8544_target(NULL);
+}
+
+/* Temporal greyscale - The planes are sent in turn from the SysTick interrupt (1kHz) */
+static void test_lcd_grey()
+{
+    static uint8_t plane_buf[2][2][PCD8544_BUFFER_SZ];
+    pcd_8544_surface_t planes[2][2];
+    pcd_8544_grey_t grey;
+
+    for(uint8_t p = 0; p < 2; p++)
+    {
+        PCD8544_surface_init(&planes[p][0], plane_buf[p][0], PCD8544_WIDTH, PCD8544_HEIGHT);
+        PCD8544_surface_init(&planes[p][1], plane_buf[p][1], PCD8544_WIDTH, PCD8544_HEIGHT);
+    }
+
+    /* The 4 levels as bars */
+    for(uint8_t level = 0; level < 4; level++) grey_rect(planes[0], level * 21, level * 21 + 20, 0, 47, level);
+
+    if(!PCD8544_grey_start(&grey, plane_buf[0][0], plane_buf[0][1])) return;
+
+    /* Rates over one second - Every frame is a full plane */
+    HAL_Delay(100);
+    uint32_t frames = grey.frames, dropped = grey.dropped, start = HAL_GetTick();
+    HAL_Delay(1000);
+    uint32_t ms = HAL_GetTick() - start;
+    frames = (grey.frames - frames) * 1000 / ms;
+    dropped = (grey.dropped - dropped) * 1000 / ms;
+    printf("\t[1]Grey levels - %ld frames/s (%ld dropped), SPI %ld bit/s, cycle %ld Hz\n",
+           frames, dropped, frames * PCD8544_BUFFER_SZ * 8, frames / PCD8544_GREY_CYCLE);
+    HAL_Delay(2000);
+
+    /* Double buffered animation - Draw the hidden pair, then show it from the next cycle */
+    for(uint8_t i = 0, p = 1; i < 64; i++, p ^= 1)
+    {
+        while(grey.pending);
+
+        grey_rect(planes[p], 0, PCD8544_WIDTH - 1, 0, PCD8544_HEIGHT - 1, 1);
+        grey_rect(planes[p], i, i + 19, 14, 33, 3);
+        grey_rect(planes[p], 63 - i, 82 - i, 4, 43, 2);
+        PCD8544_grey_show(plane_buf[p][0], plane_buf[p][1]);
+
+        HAL_Delay(40);
+    }
+    printf("\t[2]Double buffered greyscale animation\n");
+
+    PCD8544_grey_stop();
+    PCD8544_refresh();
+    SCREEN_DELAY_FILL(1000, false);
+}
+
+/* Composes layers - A popup and a cursor come and go over the content without redrawing it */
+static void test_lcd_layers()
+{
+    static uint8_t back_buf[PCD8544_BUFFER_SZ], text_buf[PCD8544_SURFACE_SZ(76, 40)];
+    static uint8_t popup_buf[PCD8544_SURFACE_SZ(48, 24)], popup_mask[PCD8544_SURFACE_SZ(48, 24)];
+    static uint8_t cursor_buf[PCD8544_SURFACE_SZ(8, 8)];
+    pcd_8544_surface_t back, text, popup, popup_m, cursor;
+    pcd_8544_compositor_t comp;
+    uint32_t time, max_time = 0;
+
+    /* Background pattern, content, a popup with rounded corners and a block cursor */
+    PCD8544_surface_init(&back, back_buf, PCD8544_WIDTH, PCD8544_HEIGHT);
+    PCD8544_target(&back);
+    PCD8544_pattern(PCD8544_hatch(PCD8544_HATCH_DIAGONAL));
+    PCD8544_draw_rectangle(0, 83, 0, 47, true, true);
+    PCD8544_pattern(NULL);
+
+    PCD8544_surface_init(&text, text_buf, 76, 40);
+    PCD8544_target(&text);
+    PCD8544_fill(false);
+    PCD8544_draw_rectangle(0, 75, 0, 39, true, false);
+    PCD8544_print_fstr("Layers", SMALL_FONT, 4, 4, false);
+
+    PCD8544_surface_init(&popup_m, popup_mask, 48, 24);
+    PCD8544_target(&popup_m);
+    PCD8544_fill(false);
+    PCD8544_draw_round_rect(0, 47, 0, 23, 4, true, true);
+
+    PCD8544_surface_init(&popup, popup_buf, 48, 24);
+    PCD8544_target(&popup);
+    PCD8544_fill(false);
+    PCD8544_draw_round_rect(0, 47, 0, 23, 4, true, false);
+    PCD8544_print_fstr("Popup", SMALL_FONT, 8, 8, false);
+
+    PCD8544_surface_init(&cursor, cursor_buf, 8, 8);
+    PCD8544_target(&cursor);
+    PCD8544_fill(true);
+    PCD8544_target(NULL);
+
+    /* Bottom to top - The content panel covers the middle of the pattern */
+    PCD8544_compositor_init(&comp);
+    PCD8544_layer_add(&comp, &back, PCD8544_BLEND_OR);
+    pcd_8544_layer_t *text_l = PCD8544_layer_add(&comp, &text, PCD8544_BLEND_REPLACE);
+    pcd_8544_layer_t *popup_l = PCD8544_layer_add(&comp, &popup, PCD8544_BLEND_REPLACE);
+    pcd_8544_layer_t *cursor_l = PCD8544_layer_add(&comp, &cursor, PCD8544_BLEND_XOR);
+    PCD8544_layer_blend(popup_l, PCD8544_BLEND_REPLACE, popup_mask);
+    PCD8544_layer_move(text_l, 4, 4);
+    PCD8544_layer_move(popup_l, 18, 12);
+    PCD8544_layer_show(popup_l, false);
+
+    START_TIMER();
+    PCD8544_compositor_update(&comp);
+    time = GET_TIMER();
+    printf("\t[1]Composing all the layers - Time:%ld\n", time);
+    HAL_Delay(2000);
+
+    /* Cursor moving over the content, popup coming and going, a counter in the content */
+    for(uint8_t i = 0; i < 120; i++)
+    {
+        char count[4] = { '0' + (i / 100), '0' + (i / 10) % 10, '0' + i % 10, '\0' };
+
+        PCD8544_layer_move(cursor_l, 8 + (i % 64), 30);
+        if(!(i % 40)) PCD8544_layer_show(popup_l, !popup_l->visible);
+        if(!(i % 8))
+        {
+            PCD8544_target(&text);
+            PCD8544_print_fstr(count, SMALL_FONT, 52, 4, false);
+            PCD8544_target(NULL);
+            PCD8544_layer_damage(text_l, 52, 69, 4, 11);
+        }
+
+        START_TIMER();
+        PCD8544_compositor_update(&comp);
+        time = GET_TIMER();
+        if(time > max_time && i) max_time = time;
+
+        HAL_Delay(30);
+    }
+    printf("\t[2]Overlays over the content - Worst update time:%ld\n", max_time);
+    SCREEN_DELAY_FILL(3000, false);
 }
 
 /* Draw and testes printing text functionality */
@@ -677,6 +1421,16 @@ static void test_lcd_text()
     PCD8544_refresh();
     SCREEN_DELAY_FILL(5000, false);
     printf("\t[12]Printing free text 3 - Time:%ld\n", time);
+
+
+    /* Test 13 - Scaled text, a clock out of the large and small fonts */
+    START_TIMER();
+    PCD8544_print_fstr_scaled("12:34", LARGE_FONT, 2, 4, 2, false);
+    PCD8544_print_fstr_scaled("PM", SMALL_FONT, 28, 26, 3, false);
+    time = GET_TIMER();
+    PCD8544_refresh();
+    SCREEN_DELAY_FILL(5000, false);
+    printf("\t[13]Printing scaled text - Time:%ld\n", time);
 }
 
 /**********************************/
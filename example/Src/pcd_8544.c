@@ -5,6 +5,7 @@
 
 #include <pcd_8544.h>       /* External header */
 #include <pcd_8544_font.h>
+#include <pcd_8544_bayer.h>
 
 #include <string.h>         /* For memcpy */
 #include <stdio.h>          /* TODO - For debug printf */
@@ -15,6 +16,14 @@
 #define LCDHEIGHT           PCD8544_HEIGHT
 #define LCDBUFFER_SZ        PCD8544_BUFFER_SZ
 
+/* Draw target parameters - The screen or an offscreen surface */
+#define TARGET_BUFFER       (_screen_h->target.buffer)
+#define TARGET_WIDTH        (_screen_h->target.width)
+#define TARGET_HEIGHT       (_screen_h->target.height)
+#define TARGET_STRIDE       (_screen_h->target.stride)
+#define TARGET_BANKS        ((_screen_h->target.height + 7) >> 3)
+#define TARGET_SZ           (TARGET_STRIDE * TARGET_BANKS)
+
 /* Basic instruction set - Set power and instruction set */
 #define PCD8544_FUNCTIONSET             0x20
 #define PCD8544_POWERDOWN               0x04        /* Function set, Power down mode */
@@ -63,10 +72,156 @@
 /* Handle to be used for the screen */
 static pcd_8544_t *_screen_h = NULL;
 
+/* Transparency of the blits without a mask */
+#define _BLIT_OPAQUE        0x00        /* Every pixel is drawn */
+#define _BLIT_KEY_WHITE     0x01        /* White pixels are transparent */
+#define _BLIT_KEY_BLACK     0x02        /* Black pixels are transparent */
+
+/* Word type for the SWAR kernels - Allowed to alias the byte buffer */
+typedef uint32_t __attribute__((__may_alias__)) _word_t;
+
+/* State of a flood fill operation */
+typedef struct
+{
+    pcd_8544_span_t *stack;                 /* Span stack given by the user */
+    uint16_t sp, size;                      /* Stack pointer and number of entries */
+    bool target, overflow;                  /* Color to replace and overflow flag */
+}_fill_state_t;
+
+/* Walker of the flood fill along the border of an area, when its stack is full */
+typedef struct
+{
+    int16_t x, y;                           /* Current pixel */
+    uint8_t dir;                            /* Heading, clockwise from the right (see _walk_dx) */
+}_walk_t;
+
+/* Destination of a bank of a run-length encoded bitmap - Its bytes land in two banks of the buffer */
+typedef struct
+{
+    uint8_t *lo, *hi;           /* Buffer bytes of the first column inside the clip */
+    uint8_t m_lo, m_hi;         /* Rows drawn in each bank, 0 if the bank is clipped */
+    uint8_t ix0, ix1;           /* Columns inside the clip */
+    uint8_t shift, rop;
+}_rle_dst_t;
+
+/* Resumable decoder of a run-length encoded stream */
+typedef struct
+{
+    const uint8_t *data;        /* Next byte of the stream */
+    uint8_t len;                /* Bytes left in the current packet */
+    uint8_t byte;               /* The repeated byte, for runs */
+    bool run;
+}_rle_stream_t;
+
+/* Parameters of a font - The glyphs start at the space character */
+typedef struct
+{
+    const uint8_t *glyphs;
+    uint8_t width, height;      /* Size of a character in pixels */
+    uint8_t byte_num;           /* Bytes per glyph, fewer than the width if the columns are packed */
+}_font_t;
+
+static const _font_t _small_font = { small_font, 4, 6, 3 };
+static const _font_t _medium_font = { medium_font, 5, 7, 5 };
+static const _font_t _large_font = { large_font, 6, 8, 6 };
+
+/* Stipple patterns - One byte per column (x mod 8), each bit is a row (y mod 8) */
+static const uint8_t _solid_pattern[8] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+static const uint8_t _clear_pattern[8] = { 0 };
+
+static const uint8_t _hatch_patterns[][8] =
+{
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11 },     /* PCD8544_HATCH_HORIZONTAL */
+    { 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00 },     /* PCD8544_HATCH_VERTICAL */
+    { 0x88, 0x44, 0x22, 0x11, 0x88, 0x44, 0x22, 0x11 },     /* PCD8544_HATCH_DIAGONAL */
+    { 0x11, 0x22, 0x44, 0x88, 0x11, 0x22, 0x44, 0x88 },     /* PCD8544_HATCH_BACK_DIAGONAL */
+    { 0xff, 0x11, 0x11, 0x11, 0xff, 0x11, 0x11, 0x11 },     /* PCD8544_HATCH_CROSS */
+    { 0x99, 0x66, 0x66, 0x99, 0x99, 0x66, 0x66, 0x99 },     /* PCD8544_HATCH_DIAGONAL_CROSS */
+};
+
+/* Headings of the flood fill walker, clockwise from the right */
+static const int8_t _walk_dx[4] = { 1, 0, -1, 0 };
+static const int8_t _walk_dy[4] = { 0, 1, 0, -1 };
+
+/* The 8 neighbours of a pixel, clockwise from the top - From each one to the next is heading (i >> 1) */
+static const int8_t _ring_dx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int8_t _ring_dy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+/* Bit reversal of a byte - Mirrors a column of 8 pixels vertically */
+static const uint8_t _bit_reverse[256] =
+{
+    0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0, 0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0,
+    0x08, 0x88, 0x48, 0xc8, 0x28, 0xa8, 0x68, 0xe8, 0x18, 0x98, 0x58, 0xd8, 0x38, 0xb8, 0x78, 0xf8,
+    0x04, 0x84, 0x44, 0xc4, 0x24, 0xa4, 0x64, 0xe4, 0x14, 0x94, 0x54, 0xd4, 0x34, 0xb4, 0x74, 0xf4,
+    0x0c, 0x8c, 0x4c, 0xcc, 0x2c, 0xac, 0x6c, 0xec, 0x1c, 0x9c, 0x5c, 0xdc, 0x3c, 0xbc, 0x7c, 0xfc,
+    0x02, 0x82, 0x42, 0xc2, 0x22, 0xa2, 0x62, 0xe2, 0x12, 0x92, 0x52, 0xd2, 0x32, 0xb2, 0x72, 0xf2,
+    0x0a, 0x8a, 0x4a, 0xca, 0x2a, 0xaa, 0x6a, 0xea, 0x1a, 0x9a, 0x5a, 0xda, 0x3a, 0xba, 0x7a, 0xfa,
+    0x06, 0x86, 0x46, 0xc6, 0x26, 0xa6, 0x66, 0xe6, 0x16, 0x96, 0x56, 0xd6, 0x36, 0xb6, 0x76, 0xf6,
+    0x0e, 0x8e, 0x4e, 0xce, 0x2e, 0xae, 0x6e, 0xee, 0x1e, 0x9e, 0x5e, 0xde, 0x3e, 0xbe, 0x7e, 0xfe,
+    0x01, 0x81, 0x41, 0xc1, 0x21, 0xa1, 0x61, 0xe1, 0x11, 0x91, 0x51, 0xd1, 0x31, 0xb1, 0x71, 0xf1,
+    0x09, 0x89, 0x49, 0xc9, 0x29, 0xa9, 0x69, 0xe9, 0x19, 0x99, 0x59, 0xd9, 0x39, 0xb9, 0x79, 0xf9,
+    0x05, 0x85, 0x45, 0xc5, 0x25, 0xa5, 0x65, 0xe5, 0x15, 0x95, 0x55, 0xd5, 0x35, 0xb5, 0x75, 0xf5,
+    0x0d, 0x8d, 0x4d, 0xcd, 0x2d, 0xad, 0x6d, 0xed, 0x1d, 0x9d, 0x5d, 0xdd, 0x3d, 0xbd, 0x7d, 0xfd,
+    0x03, 0x83, 0x43, 0xc3, 0x23, 0xa3, 0x63, 0xe3, 0x13, 0x93, 0x53, 0xd3, 0x33, 0xb3, 0x73, 0xf3,
+    0x0b, 0x8b, 0x4b, 0xcb, 0x2b, 0xab, 0x6b, 0xeb, 0x1b, 0x9b, 0x5b, 0xdb, 0x3b, 0xbb, 0x7b, 0xfb,
+    0x07, 0x87, 0x47, 0xc7, 0x27, 0xa7, 0x67, 0xe7, 0x17, 0x97, 0x57, 0xd7, 0x37, 0xb7, 0x77, 0xf7,
+    0x0f, 0x8f, 0x4f, 0xcf, 0x2f, 0xaf, 0x6f, 0xef, 0x1f, 0x9f, 0x5f, 0xdf, 0x3f, 0xbf, 0x7f, 0xff,
+};
+
+/* Every bit doubled - A bank byte becomes two banks, for the 2x and 4x scaling */
+static const uint16_t _expand_2x[256] =
+{
+    0x0000, 0x0003, 0x000c, 0x000f, 0x0030, 0x0033, 0x003c, 0x003f,
+    0x00c0, 0x00c3, 0x00cc, 0x00cf, 0x00f0, 0x00f3, 0x00fc, 0x00ff,
+    0x0300, 0x0303, 0x030c, 0x030f, 0x0330, 0x0333, 0x033c, 0x033f,
+    0x03c0, 0x03c3, 0x03cc, 0x03cf, 0x03f0, 0x03f3, 0x03fc, 0x03ff,
+    0x0c00, 0x0c03, 0x0c0c, 0x0c0f, 0x0c30, 0x0c33, 0x0c3c, 0x0c3f,
+    0x0cc0, 0x0cc3, 0x0ccc, 0x0ccf, 0x0cf0, 0x0cf3, 0x0cfc, 0x0cff,
+    0x0f00, 0x0f03, 0x0f0c, 0x0f0f, 0x0f30, 0x0f33, 0x0f3c, 0x0f3f,
+    0x0fc0, 0x0fc3, 0x0fcc, 0x0fcf, 0x0ff0, 0x0ff3, 0x0ffc, 0x0fff,
+    0x3000, 0x3003, 0x300c, 0x300f, 0x3030, 0x3033, 0x303c, 0x303f,
+    0x30c0, 0x30c3, 0x30cc, 0x30cf, 0x30f0, 0x30f3, 0x30fc, 0x30ff,
+    0x3300, 0x3303, 0x330c, 0x330f, 0x3330, 0x3333, 0x333c, 0x333f,
+    0x33c0, 0x33c3, 0x33cc, 0x33cf, 0x33f0, 0x33f3, 0x33fc, 0x33ff,
+    0x3c00, 0x3c03, 0x3c0c, 0x3c0f, 0x3c30, 0x3c33, 0x3c3c, 0x3c3f,
+    0x3cc0, 0x3cc3, 0x3ccc, 0x3ccf, 0x3cf0, 0x3cf3, 0x3cfc, 0x3cff,
+    0x3f00, 0x3f03, 0x3f0c, 0x3f0f, 0x3f30, 0x3f33, 0x3f3c, 0x3f3f,
+    0x3fc0, 0x3fc3, 0x3fcc, 0x3fcf, 0x3ff0, 0x3ff3, 0x3ffc, 0x3fff,
+    0xc000, 0xc003, 0xc00c, 0xc00f, 0xc030, 0xc033, 0xc03c, 0xc03f,
+    0xc0c0, 0xc0c3, 0xc0cc, 0xc0cf, 0xc0f0, 0xc0f3, 0xc0fc, 0xc0ff,
+    0xc300, 0xc303, 0xc30c, 0xc30f, 0xc330, 0xc333, 0xc33c, 0xc33f,
+    0xc3c0, 0xc3c3, 0xc3cc, 0xc3cf, 0xc3f0, 0xc3f3, 0xc3fc, 0xc3ff,
+    0xcc00, 0xcc03, 0xcc0c, 0xcc0f, 0xcc30, 0xcc33, 0xcc3c, 0xcc3f,
+    0xccc0, 0xccc3, 0xcccc, 0xcccf, 0xccf0, 0xccf3, 0xccfc, 0xccff,
+    0xcf00, 0xcf03, 0xcf0c, 0xcf0f, 0xcf30, 0xcf33, 0xcf3c, 0xcf3f,
+    0xcfc0, 0xcfc3, 0xcfcc, 0xcfcf, 0xcff0, 0xcff3, 0xcffc, 0xcfff,
+    0xf000, 0xf003, 0xf00c, 0xf00f, 0xf030, 0xf033, 0xf03c, 0xf03f,
+    0xf0c0, 0xf0c3, 0xf0cc, 0xf0cf, 0xf0f0, 0xf0f3, 0xf0fc, 0xf0ff,
+    0xf300, 0xf303, 0xf30c, 0xf30f, 0xf330, 0xf333, 0xf33c, 0xf33f,
+    0xf3c0, 0xf3c3, 0xf3cc, 0xf3cf, 0xf3f0, 0xf3f3, 0xf3fc, 0xf3ff,
+    0xfc00, 0xfc03, 0xfc0c, 0xfc0f, 0xfc30, 0xfc33, 0xfc3c, 0xfc3f,
+    0xfcc0, 0xfcc3, 0xfccc, 0xfccf, 0xfcf0, 0xfcf3, 0xfcfc, 0xfcff,
+    0xff00, 0xff03, 0xff0c, 0xff0f, 0xff30, 0xff33, 0xff3c, 0xff3f,
+    0xffc0, 0xffc3, 0xffcc, 0xffcf, 0xfff0, 0xfff3, 0xfffc, 0xffff,
+};
+
+/* Every bit tripled - Per nibble, for the 3x scaling */
+static const uint16_t _expand_3x[16] =
+{
+    0x000, 0x007, 0x038, 0x03f, 0x1c0, 0x1c7, 0x1f8, 0x1ff,
+    0xe00, 0xe07, 0xe38, 0xe3f, 0xfc0, 0xfc7, 0xff8, 0xfff,
+};
+
+/* Chunks of the streamed refresh - One is filled while the other is sent */
+#define STREAM_CHUNK_SZ     32
+
 #ifdef PCD8544_DMA_ACTIVE
     /* We need to have a constant buffer for DMA transfers (commands at least) */
     static uint8_t command_buffer[7];
 
+    /* Chunks of the streamed refresh, the DMA reads them after the call returns */
+    static uint8_t stream_buffer[2][STREAM_CHUNK_SZ];
+
     /*!
         @brief    The internal ISR callback when a DMA transfer is complete.
         This unfortunately might be need to be defined somewhere else, in case
@@ -85,36 +240,110 @@ static pcd_8544_t *_screen_h = NULL;
 #endif
 
 /*!
-    @brief    Set a pixel's value. Internal routine, no error checking performed.
-    @param    x         x-coordinate
-    @param    y         y-coordinate
-    @param    color     Black(True) or White(False).
+    @brief    Combines a source byte with a destination byte. Internal routine.
+    @param    dst       The destination byte
+    @param    mask      The bits of the byte to affect
+    @param    src       The source bits
+    @param    rop       The raster operation
+    @return             The new destination byte
 */
-static void _set_single_pixel(uint8_t x, uint8_t y, bool color)
+static inline uint8_t _rop_apply(uint8_t dst, uint8_t mask, uint8_t src, uint8_t rop)
 {
-    uint16_t pos = ((uint16_t)y>>3) * LCDWIDTH + x;
-    ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at _set_single_pixel %d\n", pos);
-
-    if(color)
-        _screen_h->buffer[pos] |= 1 << (y & 0x07);
-    else
-        _screen_h->buffer[pos] &= ~(1 << (y & 0x07));
+    switch(rop)
+    {
+        case PCD8544_ROP_OR:        return dst | (src & mask);
+        case PCD8544_ROP_XOR:       return dst ^ (src & mask);
+        case PCD8544_ROP_ANDNOT:    return dst & ~(src & mask);
+        case PCD8544_ROP_AND:       return dst & (src | ~mask);
+        default:                    return (dst & ~mask) | (src & mask);
+    }
 }
 
 /*!
-    @brief    Set a pixel's value. Internal routine used for loops, no error checking performed.
+    @brief    Combines a source byte with a buffer byte, using the current raster operation.
+    Internal routine, no error checking performed.
     @param    pos       Position in the buffer
-    @param    mask      The mask to apply
+    @param    mask      The bits of the byte to affect
+    @param    src       The source bits
+*/
+static void _rop_byte(uint16_t pos, uint8_t mask, uint8_t src)
+{
+    ASSERT_DEBUG(pos >= TARGET_SZ, "Error at _rop_byte %d\n", pos);
+    uint8_t *dst = &TARGET_BUFFER[pos];
+
+    *dst = _rop_apply(*dst, mask, src, _screen_h->rop);
+}
+
+/*!
+    @brief    Combines a run of source bytes with a run of buffer bytes of the same bank, using
+    a raster operation - SWAR kernel used by the fills, lines and region inversion.
+    The source repeats every 8 bytes (dst[i] uses src[i mod 8]), which covers solid colors and
+    stipple patterns. After a few head bytes the run is aligned to 4 bytes and processed one
+    32-bit word at a time, with the mask replicated in all the bytes of the word.
+    Internal routine, no error checking performed.
+    @param    dst       First byte of the run in the buffer
+    @param    len       Number of bytes
+    @param    mask      The bits of each byte to affect
+    @param    src       The 8 source bytes
+    @param    rop       The raster operation
+*/
+static void _rop_span(uint8_t *dst, uint8_t len, uint8_t mask, const uint8_t *src, uint8_t rop)
+{
+    uint8_t i = 0;
+
+    /* Head - Up to the first word boundary */
+    for(; i < len && ((uintptr_t)(dst + i) & 0x03); i++) dst[i] = _rop_apply(dst[i], mask, src[i & 0x07], rop);
+
+    if(len - i >= 4)
+    {
+        /* Source words for even and odd word indices, masked beforehand */
+        uint8_t tmp[8] = { 0 };
+        for(uint8_t k = 0; k < 8 && k < len - i; k++) tmp[k] = src[(i + k) & 0x07] & mask;
+
+        _word_t w_src[2], w_mask = mask * 0x01010101UL;
+        memcpy(w_src, tmp, sizeof(w_src));
+
+        _word_t *w_dst = (_word_t *)(dst + i);
+        uint8_t words = (len - i) >> 2;
+
+        switch(rop)
+        {
+            case PCD8544_ROP_OR:
+                for(uint8_t k = 0; k < words; k++) w_dst[k] |= w_src[k & 0x01];
+                break;
+            case PCD8544_ROP_XOR:
+                for(uint8_t k = 0; k < words; k++) w_dst[k] ^= w_src[k & 0x01];
+                break;
+            case PCD8544_ROP_ANDNOT:
+                for(uint8_t k = 0; k < words; k++) w_dst[k] &= ~w_src[k & 0x01];
+                break;
+            case PCD8544_ROP_AND:
+                for(uint8_t k = 0; k < words; k++) w_dst[k] &= w_src[k & 0x01] | ~w_mask;
+                break;
+            default:
+                for(uint8_t k = 0; k < words; k++) w_dst[k] = (w_dst[k] & ~w_mask) | w_src[k & 0x01];
+                break;
+        }
+
+        i += words << 2;
+    }
+
+    /* Tail - Leftover bytes */
+    for(; i < len; i++) dst[i] = _rop_apply(dst[i], mask, src[i & 0x07], rop);
+}
+
+/*!
+    @brief    Set a pixel's value. Internal routine, no error checking performed.
+    @param    x         x-coordinate
+    @param    y         y-coordinate
     @param    color     Black(True) or White(False).
 */
-static void _set_single_pixel_opt(uint16_t pos, uint8_t mask, bool color)
+static void _set_single_pixel(uint8_t x, uint8_t y, bool color)
 {
-    ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at _set_single_pixel_opt %d\n", pos);
+    uint16_t pos = ((uint16_t)y>>3) * TARGET_STRIDE + x;
+    ASSERT_DEBUG(pos >= TARGET_SZ, "Error at _set_single_pixel %d\n", pos);
 
-    if(color)
-        _screen_h->buffer[pos] |= mask;
-    else
-        _screen_h->buffer[pos] &= ~mask;
+    _rop_byte(pos, 1 << (y & 0x07), color ? 0xff : 0);
 }
 
 /*!
@@ -126,10 +355,10 @@ static void _set_single_pixel_opt(uint16_t pos, uint8_t mask, bool color)
 static uint8_t _get_single_pixel(uint8_t x, uint8_t y)
 {
     /* First find the exact position */
-    uint16_t pos = ((uint16_t)y>>3) * LCDWIDTH + x;
-    ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at _get_single_pixel %d\n", pos);
+    uint16_t pos = ((uint16_t)y>>3) * TARGET_STRIDE + x;
+    ASSERT_DEBUG(pos >= TARGET_SZ, "Error at _get_single_pixel %d\n", pos);
 
-    return (_screen_h->buffer[pos] >> (y & 0x07)) & 0x01;
+    return (TARGET_BUFFER[pos] >> (y & 0x07)) & 0x01;
 }
 
 /*!
@@ -149,906 +378,2810 @@ static bool _get_bmp_pixel(const uint8_t *bitmap, uint8_t x, uint8_t y, uint8_t
 }
 
 /*!
-    @brief    Get a pixel's value from a bitmap array.
-    Internal routine and different variant than the normal version.
-    @param    bitmap    The bitmap array
-    @param    pos       The position in the array
-    @param    shift     The shift value
-    @return             Black(True) or White(False).
+    @brief    Checks if a pixel is inside the clip rectangle. Internal routine.
+    @param    x     x-coordinate
+    @param    y     y-coordinate
+    @return         True if the pixel can be drawn.
 */
-static bool _get_bmp_pixel_opt(const uint8_t *bitmap, uint16_t pos, uint8_t shift)
+static bool _in_clip(int16_t x, int16_t y)
 {
-    return (bitmap[pos] >> shift) & 0x01;
+    const pcd_8544_rect_t *clip = &_screen_h->clip;
+    return x >= clip->x0 && x <= clip->x1 && y >= clip->y0 && y <= clip->y1;
 }
 
 /*!
-    @brief    Set multiple pixel values. Internal routine, no error checking performed.
-    The routine sets pixels of a single bank(check documentation for the display's pixel layout).
-    The color goes from the LSB to MSB in the buffer, or from the top to the bottom in the actual
-    display.
-    @param    pos     The bank position in the buffer
-    @param    num     Number of pixels to color, must be less than 8(bank size).
-    @param    color   Either set pixels to black(true) or white(false).
+    @brief    Set a pixel's value if it is inside the clip rectangle. Internal routine.
+    @param    x       x-coordinate, can be out of bounds
+    @param    y       y-coordinate, can be out of bounds
+    @param    color   Black(true) or white(false)
 */
-static void _set_pixels_lsb2msb(uint16_t pos, uint8_t num, bool color)
+static void _set_pixel_clip(int16_t x, int16_t y, bool color)
 {
-    ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at _set_pixels_lsb2msb\n");
-    ASSERT_DEBUG(num >= 8, "Error at _set_pixels_lsb2msb\n");
+    if(_in_clip(x, y)) _set_single_pixel(x, y, color);
+}
 
-    if(color)
-        _screen_h->buffer[pos] |= (1 << num) - 1;
-    else
-        _screen_h->buffer[pos] &= ~((1 << num) - 1);
+/*!
+    @brief    Checks if a bounding box intersects the clip rectangle, used for early-outs.
+    Internal routine.
+    @param    x0     Left-most x-coordinate
+    @param    x1     Right-most x-coordinate
+    @param    y0     Uppermost y-coordinate
+    @param    y1     Lowermost y-coordinate
+    @return          True if something of the box can be drawn.
+*/
+static bool _bbox_visible(int16_t x0, int16_t x1, int16_t y0, int16_t y1)
+{
+    const pcd_8544_rect_t *clip = &_screen_h->clip;
+    return x1 >= clip->x0 && x0 <= clip->x1 && y1 >= clip->y0 && y0 <= clip->y1;
 }
 
 /*!
-    @brief    Set multiple pixel values. Internal routine, no error checking performed.
-    The routine sets pixels of a single bank(check documentation for the display's pixel layout).
-    The color goes from the MSB to LSB in the buffer, or from the bottom to the top in the actual
-    display.
-    @param    pos     The bank position in the buffer
-    @param    num     Number of pixels to color, must be less than 8(bank size).
-    @param    color   Either set pixels to black(true) or white(false).
+    @brief    Clips a rectangle (inclusive coordinates) to the clip rectangle. Internal routine.
+    @param    x0     Left-most x-coordinate
+    @param    x1     Right-most x-coordinate
+    @param    y0     Uppermost y-coordinate
+    @param    y1     Lowermost y-coordinate
+    @return          False if nothing is left to draw.
 */
-static void _set_pixels_msb2lsb(uint16_t pos, uint8_t num, bool color)
+static bool _clip_rect(int16_t *x0, int16_t *x1, int16_t *y0, int16_t *y1)
 {
-    ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at _set_pixels_invert_msb2lsb\n");
-    ASSERT_DEBUG(num >= 8, "Error at _set_pixels_invert_msb2lsb\n");
+    const pcd_8544_rect_t *clip = &_screen_h->clip;
 
-    if(color)
-        _screen_h->buffer[pos] |= ~(0xff >> num);
-    else
-        _screen_h->buffer[pos] &= 0xff >> num;
+    if(*x0 < clip->x0) *x0 = clip->x0;
+    if(*x1 > clip->x1) *x1 = clip->x1;
+    if(*y0 < clip->y0) *y0 = clip->y0;
+    if(*y1 > clip->y1) *y1 = clip->y1;
+
+    return (*x0 <= *x1) && (*y0 <= *y1);
 }
 
 /*!
-    @brief    Draws a generic line. Internal routine, it uses Bresenhm's algorithm and is based on the implementation
-    by the Adafruit GFX library.
-    @param    x0     Starting x-coordinate
-    @param    x1     Ending x-coordinate
-    @param    y0     Starting y-coordinate
-    @param    y1     Ending y-coordinate
-    @param    color  Black(true)/white(false)
+    @brief    Returns the mask of the rows of a bank that are inside a row range. Internal routine.
+    @param    bank   The bank
+    @param    y0     Uppermost y-coordinate of the range
+    @param    y1     Lowermost y-coordinate of the range
+    @return          The mask, 0 if the bank is outside the range.
 */
-static void _draw_generic_line(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color)
+static uint8_t _bank_mask(uint8_t bank, int16_t y0, int16_t y1)
 {
-    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+    int16_t top = y0 - (bank << 3), bot = y1 - (bank << 3);
 
-    if(steep)
+    if(bot < 0 || top > 7) return 0;
+    if(top < 0) top = 0;
+    if(bot > 7) bot = 7;
+
+    return (0xff << top) & (0xff >> (7 - bot));
+}
+
+/*!
+    @brief    Fills a block of pixels, bank by bank. Internal routine, coordinates must be clipped.
+    Banks that are covered completely are written with memset, unless a pattern or a raster
+    operation other than COPY is used.
+    @param    x0       Left-most x-coordinate
+    @param    x1       Right-most x-coordinate
+    @param    y0       Uppermost y-coordinate
+    @param    y1       Lowermost y-coordinate
+    @param    color    Black(true)/white(false)
+    @param    pattern  The 8x8 stipple pattern, NULL for a solid fill
+*/
+static void _fill_block(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color, const uint8_t *pattern)
+{
+    uint8_t len_x = x1 - x0 + 1;
+    uint8_t flip = color ? 0 : 0xff;
+    bool solid = !pattern || !memcmp(pattern, _solid_pattern, sizeof(_solid_pattern));
+
+    /* Column bytes of the pattern, rotated so that the first one is for x0 */
+    uint8_t src[8];
+    if(!pattern) pattern = _solid_pattern;
+    for(uint8_t i = 0; i < 8 && i < len_x; i++) src[i] = pattern[(x0 + i) & 0x07] ^ flip;
+
+    uint16_t pos = (y0 >> 3) * TARGET_STRIDE + x0;
+    uint8_t rop = _screen_h->rop;
+
+    for(uint8_t bank = y0 >> 3; bank <= (y1 >> 3); bank++)
     {
-        SWAP_VAR(x0, y0);
-        SWAP_VAR(x1, y1);
+        ASSERT_DEBUG(pos >= TARGET_SZ, "Error at _fill_block\n");
+        uint8_t mask = _bank_mask(bank, y0, y1);
+        uint8_t *dst = TARGET_BUFFER + pos;
+
+        if(solid && mask == 0xff && rop == PCD8544_ROP_COPY)
+            memset(dst, src[0], len_x * sizeof(uint8_t));
+        else
+            _rop_span(dst, len_x, mask, src, rop);
+
+        pos += TARGET_STRIDE;
     }
+}
 
-    if(x0 > x1)
+/*!
+    @brief    Fills a horizontal span with the current pattern. Internal routine used by the filled shapes.
+    @param    x0     Left-most x-coordinate
+    @param    x1     Right-most x-coordinate
+    @param    y      y-coordinate
+    @param    color  Black(true)/white(false)
+*/
+static void _fill_hspan(int16_t x0, int16_t x1, int16_t y, bool color)
+{
+    int16_t y1 = y;
+    if(_clip_rect(&x0, &x1, &y, &y1)) _fill_block(x0, x1, y, y1, color, _screen_h->pattern);
+}
+
+/*!
+    @brief    Fills a vertical span with the current pattern. Internal routine used by the filled shapes.
+    @param    x      x-coordinate
+    @param    y0     Uppermost y-coordinate
+    @param    y1     Lowermost y-coordinate
+    @param    color  Black(true)/white(false)
+*/
+static void _fill_vspan(int16_t x, int16_t y0, int16_t y1, bool color)
+{
+    int16_t x1 = x;
+    if(_clip_rect(&x, &x1, &y0, &y1)) _fill_block(x, x1, y0, y1, color, _screen_h->pattern);
+}
+
+/*!
+    @brief    Draws the four arcs of a circle split into quadrants - Uses the Midpoint circle algorithm.
+    The quadrants are centered at (xl, yt), (xr, yt), (xl, yb) and (xr, yb), so for a circle
+    all centers are the same and for a rounded rectangle they are the centers of the corners.
+    Points on the axes are not drawn, they belong to the straight edges. Internal routine.
+    @param    xl     Left center x-coordinate
+    @param    xr     Right center x-coordinate
+    @param    yt     Top center y-coordinate
+    @param    yb     Bottom center y-coordinate
+    @param    r      Radius
+    @param    color  Black(true)/white(false)
+*/
+static void _draw_circle_arcs(int16_t xl, int16_t xr, int16_t yt, int16_t yb, uint8_t r, bool color)
+{
+    int16_t a = 1;
+    int16_t b = r;
+    int16_t p = 1 - r;
+
+    /* Step past the point on the axes */
+    if(p < 0) p += 3;
+    else
     {
-        SWAP_VAR(x0, x1);
-        SWAP_VAR(y0, y1);
+        p += 5 - 2*b;
+        b--;
     }
 
-    int16_t dx = x1 - x0;
-    int16_t dy = abs(y1 - y0);
-    int16_t err = dx >> 1;
-    int16_t ystep = (y0 < y1) ? 1 : -1;
-
-    for (; x0 <= x1; x0++)
+    while(a <= b)
     {
-        if(steep)
+        /* Octants meet on the diagonals, draw those points once (for XOR) */
+        _set_pixel_clip(xr + a, yb + b, color);
+        _set_pixel_clip(xr + a, yt - b, color);
+        _set_pixel_clip(xl - a, yb + b, color);
+        _set_pixel_clip(xl - a, yt - b, color);
+
+        if(a != b)
         {
-            PCD8544_set_pixel(y0, x0, color);
+            _set_pixel_clip(xr + b, yb + a, color);
+            _set_pixel_clip(xr + b, yt - a, color);
+            _set_pixel_clip(xl - b, yb + a, color);
+            _set_pixel_clip(xl - b, yt - a, color);
         }
-        else
+
+        if(p < 0)
         {
-            PCD8544_set_pixel(x0, y0, color);
+            p += (3 + 2*a);
+            a++;
         }
-
-        err -= dy;
-        if(err < 0)
+        else
         {
-            y0 += ystep;
-            err += dx;
+            p += (5 + 2*(a-b));
+            a++;
+            b--;
         }
     }
 }
 
 /*!
-    @brief    SPI transmission internal routine.
-    @param    data      The SPI packet buffer to be sent
-    @param    nb_data   The number of packets(bytes) to be sent
-    @param    type      Type of transmission, true for data else command.
-    @return             Success(True) or Failure(False) of the SPI transmission.
+    @brief    Fills the columns left of xl and right of xr with the spans of a circle split
+    into quadrants (see _draw_circle_arcs) - Uses the Midpoint circle algorithm.
+    Each column is filled once, bank-wise. Internal routine.
+    @param    xl     Left center x-coordinate
+    @param    xr     Right center x-coordinate
+    @param    yt     Top center y-coordinate
+    @param    yb     Bottom center y-coordinate
+    @param    r      Radius
+    @param    color  Black(true)/white(false)
 */
-static bool _send_packet(uint8_t *data, uint16_t nb_data , bool type)
+static void _fill_circle_spans(int16_t xl, int16_t xr, int16_t yt, int16_t yb, uint8_t r, bool color)
 {
-    HAL_StatusTypeDef ret;
+    int16_t f = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+    int16_t px = x;
+    int16_t py = y;
 
-    /* Data needs DC high - Command needs DC low */
-    type ? SET_GPIO(_screen_h->dc_port, _screen_h->dc_pin) \
-         : RESET_GPIO(_screen_h->dc_port, _screen_h->dc_pin);
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
 
-    /* Chip enable - Active Low */
-    RESET_GPIO(_screen_h->ce_port, _screen_h->ce_pin);
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
 
-    #ifdef PCD8544_DMA_ACTIVE
-        /* Set handler flag */
-        _screen_h->dma_transfer = true;
+        /* These checks avoid filling a column twice, important for XOR */
+        if (x < (y + 1))
+        {
+            _fill_vspan(xr + x, yt - y, yb + y, color);
+            _fill_vspan(xl - x, yt - y, yb + y, color);
+        }
 
-        /* Transmit through SPI using DMA */
-        ret = HAL_SPI_Transmit_DMA(_screen_h->h_spi, data, nb_data);
-    #else
-        /* Transmit through SPI */
-        ret = HAL_SPI_Transmit(_screen_h->h_spi, data, nb_data, SPI_TIMEOUT);
+        if (y != py)
+        {
+            _fill_vspan(xr + py, yt - px, yb + px, color);
+            _fill_vspan(xl - py, yt - px, yb + px, color);
 
-        /* Chip disable - Active Low */
-        SET_GPIO(_screen_h->ce_port, _screen_h->ce_pin);
-    #endif
+            py = y;
+        }
 
-    return ret == HAL_OK;
+        px = x;
+    }
 }
 
 /*!
-    @brief    Creates the initialization command sequence for the screen.
-    @param    command_buffer  The buffer to write the commands in
+    @brief    Builds a destination bank byte out of the two source banks that land on it.
+    Internal routine for the blits.
+    @param    lo      The source bank shifted down, NULL if there is none
+    @param    hi      The source bank shifted up, NULL if there is none
+    @param    i       The column
+    @param    shift   The shift (y mod 8)
+    @return           The bank byte
 */
-static void _init_sequence(uint8_t *command_buffer)
+static inline uint8_t _bank_byte(const uint8_t *lo, const uint8_t *hi, uint8_t i, uint8_t shift)
 {
-    command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION;     /* Enter extended instruction mode */
-    command_buffer[1] = PCD8544_SETBIAS | _screen_h->bias;                     /* Set bias voltage */
-    command_buffer[2] = PCD8544_SETVOP | _screen_h->contast;                   /* Set contrast */
-    command_buffer[3] = PCD8544_FUNCTIONSET;                                   /* Enter normal instruction mode - Vertical display */
-    command_buffer[4] = PCD8544_SETXADDR | 0;                                  /* Initialize coordinates */
-    command_buffer[5] = PCD8544_SETYADDR | 0;                                  /* Initialize coordinates */
-    command_buffer[6] = PCD8544_DISPLAYCONTROL | PCD8544_DISPLAYNORMAL;        /* Set display to normal */
-}
+    uint8_t byte = lo ? lo[i] << shift : 0;
+    if(hi) byte |= hi[i] >> (8 - shift);
 
-/**********************************************************/
-/************************ OPERATIONS **********************/
-/**********************************************************/
+    return byte;
+}
 
 /*!
-    @brief    Initializes the display and the library with a new handle.
-    @return   Success(True) or Failure(False) of the procedure.
+    @brief    Draws a bitmap at any position - Internal routine for the bitmap and sprite blits.
+    The bitmap uses the display's layout (banks of 8 rows, stride bytes each). When y0 is not
+    a multiple of 8, every destination bank is made of two source banks, the lower one shifted
+    down (src << s) and the upper one shifted up (src >> (8 - s)). The first and last banks are
+    masked, so the whole blit is a handful of byte operations per column and bank.
+    Sprites also combine a mask, built the same way, so that dst = (dst & ~mask) | (src & mask).
+    @param    bitmap    The bitmap array
+    @param    mask      The mask array with the bitmap's layout, NULL to use the key
+    @param    key       The transparency mode when there is no mask (_BLIT_OPAQUE, _BLIT_KEY_WHITE or _BLIT_KEY_BLACK)
+    @param    x0        Leftmost x-coordinate, can be out of bounds
+    @param    y0        Uppermost y-coordinate, can be out of bounds
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+    @param    stride    The bytes per bank of the bitmap (len_x for plain bitmaps)
 */
-bool PCD8544_init(pcd_8544_t *init)
+static void _blit(const uint8_t *bitmap, const uint8_t *mask, uint8_t key, int16_t x0, int16_t y0,
+                  uint8_t len_x, uint8_t len_y, uint16_t stride)
 {
-    ASSERT_DEBUG(init == NULL, "Null pointer - PCD8544_init()\n");
+    /* Clip once - Illegal format of the bitmap or nothing to draw */
+    int16_t cx0 = x0, cx1 = x0 + len_x - 1, cy0 = y0, cy1 = y0 + len_y - 1;
+    if(!bitmap || !len_x || !len_y || !_clip_rect(&cx0, &cx1, &cy0, &cy1)) return;
 
-    /* Initialize the screen handle */
-    _screen_h = init;
+    uint8_t draw_xlen = cx1 - cx0 + 1;
+    uint8_t shift = y0 & 0x07;
+    uint8_t src_banks = (len_y + 7) >> 3;
+    uint8_t rop = _screen_h->rop;
 
-    /* Chip enable initialization - Active low */
-    SET_GPIO(_screen_h->ce_port, _screen_h->ce_pin);
+    const uint8_t *src = bitmap + (cx0 - x0);
+    const uint8_t *src_mask = mask ? mask + (cx0 - x0) : NULL;
+    uint16_t pos = (cy0 >> 3) * TARGET_STRIDE + cx0;
 
-    /* We reset for 2ms - Active low */
-    RESET_GPIO(_screen_h->rst_port, _screen_h->rst_pin);
-    HAL_Delay(2);
-    SET_GPIO(_screen_h->rst_port, _screen_h->rst_pin);
+    for(int16_t bank = cy0 >> 3; bank <= (cy1 >> 3); bank++)
+    {
+        ASSERT_DEBUG(pos >= TARGET_SZ, "Error at _blit -> %d\n", pos);
 
-    /* Sanity check for contrast-bias values */
-    if(_screen_h->contast > 0x7f) _screen_h->contast = 0x7f;
-    if(_screen_h->bias > 0x07) _screen_h->bias = 0x07;
+        /* Source banks landing in this one - Rows outside the bitmap are masked out */
+        int16_t k = bank - (y0 >> 3);
+        const uint8_t *lo = (k < src_banks) ? src + k * stride : NULL;
+        const uint8_t *hi = (shift && k > 0) ? src + (k - 1) * stride : NULL;
 
-    /* Initialize the cursor for the text printer */
-    _screen_h->x_pos = _screen_h->y_pos = 0;
+        uint8_t clip_mask = _bank_mask(bank, cy0, cy1);
+        uint8_t *dst = TARGET_BUFFER + pos;
 
-    #ifndef PCD8544_DMA_ACTIVE
-        /* Polling transfer - Allocate the buffer on the stack */
-        uint8_t command_buffer[7];
-    #else
-        /* Set DMA transfer flag */
-        _screen_h->dma_transfer = false;
-    #endif
+        if(src_mask || key != _BLIT_OPAQUE)
+        {
+            const uint8_t *mlo = (src_mask && lo) ? src_mask + k * stride : NULL;
+            const uint8_t *mhi = (src_mask && hi) ? src_mask + (k - 1) * stride : NULL;
 
-    /* List the base commands */
-    _init_sequence(command_buffer);
+            for(uint8_t i = 0; i < draw_xlen; i++)
+            {
+                uint8_t byte = _bank_byte(lo, hi, i, shift);
+                uint8_t m = src_mask ? _bank_byte(mlo, mhi, i, shift) : (key == _BLIT_KEY_WHITE) ? byte : ~byte;
+                dst[i] = _rop_apply(dst[i], clip_mask & m, byte, rop);
+            }
+        }
+        else if(!shift && rop == PCD8544_ROP_COPY && clip_mask == 0xff)
+            memcpy(dst, lo, draw_xlen * sizeof(uint8_t));
+        else if(!shift)
+            for(uint8_t i = 0; i < draw_xlen; i++) dst[i] = _rop_apply(dst[i], clip_mask, lo[i], rop);
+        else
+            for(uint8_t i = 0; i < draw_xlen; i++) dst[i] = _rop_apply(dst[i], clip_mask, _bank_byte(lo, hi, i, shift), rop);
 
-    /* Send the base commands and return code */
-    return _send_packet(command_buffer, 7, false);
+        pos += TARGET_STRIDE;
+    }
 }
 
 /*!
-    @brief    Swaps the current screen handle.
-    This is used to change the current screen that the library sends commands and updates
-    graphics into. Initialization for the new screen is the user's responsibility.
-    @param    new  The new screen handle
-    @return        The old display's handle
+    @brief    Moves the columns of a region sideways, bank by bank. Internal routine, coordinates
+    must be clipped. The exposed columns are left as they were.
+    @param    x0    Left-most x-coordinate
+    @param    x1    Right-most x-coordinate
+    @param    y0    Uppermost y-coordinate
+    @param    y1    Lowermost y-coordinate
+    @param    dx    The distance, positive to the right
 */
-pcd_8544_t *PCD8544_handle_swap(pcd_8544_t *new)
+static void _scroll_horizontal(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, int8_t dx)
 {
-    ASSERT_DEBUG(new != NULL, "Null pointer - PCD8544_handle_swap()\n");
-
-    pcd_8544_t *old = _screen_h;
-    _screen_h = new;
+    uint8_t n = (dx < 0) ? -dx : dx;
+    if(!n || n > x1 - x0) return;
 
-    return old;
-}
+    uint8_t len = x1 - x0 + 1 - n;
 
-/*!
-    @brief    Draws the contents of the buffer on the display.
-    @return   Success(True) or Failure(False) in sending the data.
-*/
-bool PCD8544_refresh()
-{
-    #ifdef PCD8544_DMA_ACTIVE
-        if(_screen_h->dma_transfer) return false;
-    #endif
-
-    /* Draw and return */
-    return _send_packet(_screen_h->buffer, LCDBUFFER_SZ, true);
+    for(uint8_t bank = y0 >> 3; bank <= (y1 >> 3); bank++)
+    {
+        uint8_t *row = TARGET_BUFFER + bank * TARGET_STRIDE + x0;
+        uint8_t *dst = (dx > 0) ? row + n : row;
+        const uint8_t *src = (dx > 0) ? row : row + n;
+        uint8_t mask = _bank_mask(bank, y0, y1);
+
+        /* Whole banks are a plain move, partial ones keep the rows outside the region */
+        if(mask == 0xff)
+            memmove(dst, src, len * sizeof(uint8_t));
+        else if(dx > 0)
+            for(uint8_t i = len; i--;) dst[i] = (dst[i] & ~mask) | (src[i] & mask);
+        else
+            for(uint8_t i = 0; i < len; i++) dst[i] = (dst[i] & ~mask) | (src[i] & mask);
+    }
 }
 
 /*!
-    @brief    Fills the display buffer with the specified color.
-    @param    color  Fill with black(true) or with white(false).
+    @brief    Shifts 4 columns of a bank (one per byte) by r rows, carrying in the rows of the
+    neighbouring bank - SWAR step of the vertical scroll.
+    @param    near   The source bank
+    @param    far    The bank after the source, in the direction the rows come from
+    @param    r      The shift, 0 to 7 rows
+    @param    down   Content moves downwards(true) or upwards(false)
+    @return          The shifted bank
 */
-void PCD8544_fill(bool color)
+static inline uint32_t _shift_bank(uint32_t near, uint32_t far, uint8_t r, bool down)
 {
-    memset(_screen_h->buffer, color ? 0xff : 0, LCDBUFFER_SZ * sizeof(uint8_t));
+    if(down)
+    {
+        uint32_t keep = 0x01010101UL * (uint8_t)(0xff << r);
+        return ((near << r) & keep) | ((far >> (8 - r)) & ~keep);
+    }
+
+    uint32_t keep = 0x01010101UL * (uint8_t)(0xff >> r);
+    return ((near >> r) & keep) | ((far << (8 - r)) & ~keep);
 }
 
 /*!
-    @brief    Inverts or uninverts the display.
-    @param    invert  True(Invert) and False(Uninvert).
-    @return           Success(True) or Failure(False) in sending the command.
+    @brief    Moves the rows of a region up or down. Internal routine, coordinates must be clipped.
+    Every destination bank is made of two source banks, shifted and merged 4 columns (a 32-bit
+    word) at a time. The banks are processed against the direction of the scroll, so the sources
+    are read before they are overwritten. The exposed rows are left as they were.
+    @param    x0    Left-most x-coordinate
+    @param    x1    Right-most x-coordinate
+    @param    y0    Uppermost y-coordinate
+    @param    y1    Lowermost y-coordinate
+    @param    dy    The distance, positive downwards
 */
-bool PCD8544_invert(bool invert)
+static void _scroll_vertical(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, int8_t dy)
 {
-#ifdef PCD8544_DMA_ACTIVE
-    /* DMA transfer - Make sure transfer is finished */
-    if(_screen_h->dma_transfer) return false;
-#else
-    /* Polling transfer - Allocate the buffer on the stack */
-    uint8_t command_buffer[3];
-#endif
+    uint8_t n = (dy < 0) ? -dy : dy;
+    if(!n || n > y1 - y0) return;
 
-    /* Commands for inversion */
-    command_buffer[0] = PCD8544_FUNCTIONSET;
-    command_buffer[1] = PCD8544_DISPLAYCONTROL | (invert ? PCD8544_DISPLAYINVERTED: PCD8544_DISPLAYNORMAL);
-    command_buffer[2] = PCD8544_FUNCTIONSET;
+    /* Rows that receive content */
+    uint8_t wy0 = (dy > 0) ? y0 + n : y0, wy1 = (dy > 0) ? y1 : y1 - n;
+    uint8_t bank0 = wy0 >> 3, bank1 = wy1 >> 3;
+    uint8_t q = n >> 3, r = n & 0x07, len = x1 - x0 + 1;
+    uint16_t stride = TARGET_STRIDE;
 
-    return _send_packet(command_buffer, 3, false);
-}
+    for(uint8_t i = 0; i <= bank1 - bank0; i++)
+    {
+        uint8_t bank = (dy > 0) ? bank1 - i : bank0 + i;
+        uint8_t *dst = TARGET_BUFFER + bank * stride + x0;
+        const uint8_t *near, *far;
 
-/*!
-    @brief    Enables or disables sleep mode.
-    @param    enable  Enable(true) sleep mode or disable(false).
-    @return           Success(True) or Failure(False) in sending the command.
-*/
-bool PCD8544_sleep_mode(bool enable)
-{
-    #ifdef PCD8544_DMA_ACTIVE
-        /* DMA transfer - Make sure transfer is finished */
-        if(_screen_h->dma_transfer) return false;
-    #else
-        /* Polling transfer - Allocate the buffer on the stack */
-        uint8_t command_buffer[7];
-    #endif
+        /* The far bank only exists inside the target - Its rows are masked out otherwise */
+        if(dy > 0)
+        {
+            near = dst - q * stride;
+            far = (bank > q) ? near - stride : NULL;
+        }
+        else
+        {
+            near = dst + q * stride;
+            far = (bank + q + 1 < TARGET_BANKS) ? near + stride : NULL;
+        }
 
-    if(enable) /* Buffer and settings are saved */
-    {
-        command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_POWERDOWN;
-        return _send_packet(command_buffer, 1, false);
-    }
+        uint32_t mask = 0x01010101UL * _bank_mask(bank, wy0, wy1);
+        uint32_t d, a, b = 0;
+        uint8_t k = 0;
 
-    /* Repeat basic initialization */
-    _init_sequence(command_buffer);
+        for(; k + 4 <= len; k += 4)
+        {
+            memcpy(&d, dst + k, 4);
+            memcpy(&a, near + k, 4);
+            if(far) memcpy(&b, far + k, 4);
 
-    return _send_packet(command_buffer, 7, false);
+            d = (d & ~mask) | (_shift_bank(a, b, r, dy > 0) & mask);
+            memcpy(dst + k, &d, 4);
+        }
+
+        for(; k < len; k++)
+        {
+            uint8_t byte = _shift_bank(near[k], far ? far[k] : 0, r, dy > 0);
+            dst[k] = (dst[k] & ~mask) | (byte & mask);
+        }
+    }
 }
 
 /*!
-    @brief    Set display's contrast value.
-    @param    contrast  The contrast value.
-    @return             Success(True) or Failure(False) in sending the command.
+    @brief    Loads an 8x8 block of a bitmap, one byte per column like the banks. Internal routine
+    for the transforms. Pixels outside the bitmap are white, so the origin can be out of bounds.
+    @param    src      The bitmap, in the display's layout
+    @param    len_x    The width of the bitmap
+    @param    len_y    The height of the bitmap
+    @param    stride   The bytes per bank of the bitmap
+    @param    x        Left-most x-coordinate of the block
+    @param    y        Uppermost y-coordinate of the block
+    @param    block    The 8 output columns
 */
-bool PCD8544_contrast(uint8_t contrast)
+static void _load_block(const uint8_t *src, uint8_t len_x, uint8_t len_y, uint16_t stride, int16_t x, int16_t y, uint8_t *block)
 {
-    #ifdef PCD8544_DMA_ACTIVE
-        /* DMA transfer - Make sure transfer is finished */
-        if(_screen_h->dma_transfer) return false;
-    #else
-        /* Polling transfer - Allocate the buffer on the stack */
-        uint8_t command_buffer[3];
-    #endif
+    /* Rows of the block inside the bitmap */
+    uint8_t valid = 0xff;
+    if(y < 0) valid <<= -y;
+    if(y + 8 > len_y) valid &= 0xff >> (y + 8 - len_y);
 
-    /* Update contrast value */
-    _screen_h->contast = (contrast < 0x7f) ? contrast : 0x7f;
+    int16_t bank = y >> 3;
+    uint8_t shift = y & 0x07;
+    const uint8_t *lo = (bank >= 0) ? src + bank * stride : NULL;
+    const uint8_t *hi = (shift && (bank + 1) * 8 < len_y) ? src + (bank + 1) * stride : NULL;
 
-    command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION;
-    command_buffer[1] = PCD8544_SETVOP | _screen_h->contast;
-    command_buffer[2] = PCD8544_FUNCTIONSET;
+    for(uint8_t i = 0; i < 8; i++, x++)
+    {
+        if(x < 0 || x >= len_x)
+        {
+            block[i] = 0;
+            continue;
+        }
 
-    return _send_packet(command_buffer, 3, false);
+        uint8_t byte = lo ? lo[x] >> shift : 0;
+        if(hi) byte |= hi[x] << (8 - shift);
+        block[i] = byte & valid;
+    }
 }
 
 /*!
-    @brief    Set display's bias value.
-    @param    bias  The bias value.
-    @return         Success(True) or Failure(False) in sending the command.
+    @brief    Transposes an 8x8 block in place, so that bit j of byte i moves to bit i of byte j.
+    Internal routine - Three delta swaps (1x1, 2x2 and 4x4 sub-blocks) on two 32-bit words.
+    @param    block    The 8 columns of the block
 */
-bool PCD8544_bias(uint8_t bias)
+static void _transpose_block(uint8_t *block)
 {
-    #ifdef PCD8544_DMA_ACTIVE
-        /* DMA transfer - Make sure transfer is finished */
-        if(_screen_h->dma_transfer) return false;
-    #else
-        /* Polling transfer - Allocate the buffer on the stack */
-        uint8_t command_buffer[3];
-    #endif
-
-    /* Update bias value */
-    _screen_h->bias = (bias < 0x07) ? bias : 0x07;
-
-    command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION;
-    command_buffer[1] = PCD8544_SETBIAS | _screen_h->bias;
-    command_buffer[2] = PCD8544_FUNCTIONSET;
-
-    return _send_packet(command_buffer, 3, false);
+    uint32_t x, y, t;
+    memcpy(&x, block, 4);
+    memcpy(&y, block + 4, 4);
+
+    t = (x ^ (x >> 7)) & 0x00aa00aaUL;  x ^= t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00aa00aaUL;  y ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000ccccUL; x ^= t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000ccccUL; y ^= t ^ (t << 14);
+    t = ((x >> 4) ^ y) & 0x0f0f0f0fUL;  y ^= t; x ^= t << 4;
+
+    memcpy(block, &x, 4);
+    memcpy(block + 4, &y, 4);
 }
 
-/**********************************************************/
-/************************ GRAPHICS ************************/
-/**********************************************************/
-
 /*!
-    @brief    Set a pixel's value.
-    @param    x       x-coordinate
-    @param    y       y-coordinate
-    @param    color   Black(true) or white(false)
+    @brief    Transforms a bitmap into another one, 8x8 blocks at a time. Internal routine, the
+    output must have the transformed size and must not overlap the input.
+    Every output block is loaded from the matching input block, transposed if needed, with its
+    columns reversed for the horizontal mirror and its bits reversed for the vertical one.
+    @param    src       The input bitmap
+    @param    len_x     The width of the input
+    @param    len_y     The height of the input
+    @param    stride    The bytes per bank of the input
+    @param    dst       The output bitmap
+    @param    d_stride  The bytes per bank of the output
+    @param    op        The transform (PCD8544_MIRROR_X, _MIRROR_Y, _TRANSPOSE or a rotation)
 */
-void PCD8544_set_pixel(uint8_t x, uint8_t y, bool color)
+static void _transform(const uint8_t *src, uint8_t len_x, uint8_t len_y, uint16_t stride, uint8_t *dst, uint16_t d_stride, uint8_t op)
 {
-    /* Sanity check */
-    if((x >= LCDWIDTH) || (y >= LCDHEIGHT)) return;
+    bool transpose = op & PCD8544_TRANSPOSE;
+    uint8_t d_len_x = transpose ? len_y : len_x, d_len_y = transpose ? len_x : len_y;
+    uint8_t block[8];
 
-    /* Call the internal routine */
-    _set_single_pixel(x, y, color);
+    for(uint8_t bank = 0; bank < (d_len_y + 7) >> 3; bank++)
+    {
+        uint8_t mask = _bank_mask(bank, 0, d_len_y - 1);
+        uint8_t *row = dst + bank * d_stride;
+
+        for(int16_t x = 0; x < d_len_x; x += 8)
+        {
+            /* Origin of the input block - Mirrors take the block from the other end */
+            int16_t bx = (op & PCD8544_MIRROR_X) ? d_len_x - 8 - x : x;
+            int16_t by = (op & PCD8544_MIRROR_Y) ? d_len_y - 8 - (bank << 3) : (bank << 3);
+
+            if(transpose)
+            {
+                _load_block(src, len_x, len_y, stride, by, bx, block);
+                _transpose_block(block);
+            }
+            else
+                _load_block(src, len_x, len_y, stride, bx, by, block);
+
+            for(uint8_t i = 0; i < 8 && x + i < d_len_x; i++)
+            {
+                uint8_t byte = block[(op & PCD8544_MIRROR_X) ? 7 - i : i];
+                if(op & PCD8544_MIRROR_Y) byte = _bit_reverse[byte];
+
+                row[x + i] = (row[x + i] & ~mask) | (byte & mask);
+            }
+        }
+    }
 }
 
 /*!
-    @brief    Returns a pixel's value.
-    @param    x   x-coordinate
-    @param    y   y-coordinate
-    @return       In case of error, 0xFF is returned, otherwise true or false.
+    @brief    Sets up the destination of a bank of a run-length encoded bitmap. Internal routine.
+    @param    dst      The destination
+    @param    x0       Leftmost x-coordinate of the bitmap
+    @param    y0       Uppermost y-coordinate of the bitmap
+    @param    cy0      Uppermost clipped y-coordinate
+    @param    cy1      Lowermost clipped y-coordinate
+    @param    bank     The bank of the bitmap
+    @param    valid    The rows of the bank inside the bitmap
 */
-uint8_t PCD8544_get_pixel(uint8_t x, uint8_t y)
+static void _rle_bank(_rle_dst_t *dst, int16_t x0, int16_t y0, int16_t cy0, int16_t cy1, uint8_t bank, uint8_t valid)
 {
-    /* Return max value in case of failure */
-    return ((x >= LCDWIDTH) || (y >= LCDHEIGHT)) ? 0xff : _get_single_pixel(x, y);
+    int16_t lo = (y0 >> 3) + bank, hi = lo + 1;
+    uint16_t pos = x0 + dst->ix0;
+
+    dst->m_lo = (lo >= (cy0 >> 3) && lo <= (cy1 >> 3)) ? (uint8_t)(valid << dst->shift) & _bank_mask(lo, cy0, cy1) : 0;
+    dst->m_hi = (dst->shift && hi >= (cy0 >> 3) && hi <= (cy1 >> 3)) ? (valid >> (8 - dst->shift)) & _bank_mask(hi, cy0, cy1) : 0;
+    dst->lo = dst->m_lo ? TARGET_BUFFER + lo * TARGET_STRIDE + pos : NULL;
+    dst->hi = dst->m_hi ? TARGET_BUFFER + hi * TARGET_STRIDE + pos : NULL;
 }
 
 /*!
-    @brief    Draw a horizontal line.
-    @param    x      Left-most x-coordinate
-    @param    y      Left-most y-coordinate
-    @param    len    The length of the line including the starting pixel
-    @param    color  Black(true)/white(false)
+    @brief    Draws a run of equal bytes of a run-length encoded bitmap. Internal routine.
+    @param    dst      The destination of the current bank
+    @param    byte     The byte
+    @param    i        The first column
+    @param    len      The number of columns
 */
-void PCD8544_draw_hline(uint8_t x, uint8_t y, uint8_t len, bool color)
+static void _rle_run(const _rle_dst_t *dst, uint8_t byte, uint8_t i, uint8_t len)
 {
-    /* Sanity check - x value is taken care of by the loop conditions */
-    if(y >= LCDHEIGHT || x >= LCDWIDTH) return;
+    int16_t a = (i > dst->ix0) ? i : dst->ix0, b = (i + len - 1 < dst->ix1) ? i + len - 1 : dst->ix1;
+    if(a > b) return;
 
-    uint16_t pos = (y >> 3) * LCDWIDTH + x;
-    if(((uint16_t)x + len) > LCDWIDTH) len = LCDWIDTH - x;
-    uint8_t common_mask = 1 << (y & 0x07);
+    uint8_t src[8];
 
-    if(color)
+    if(dst->lo)
     {
-        for(uint8_t i = 0; i < len; i++)
-        {
-            ASSERT_DEBUG((pos + i) >= LCDBUFFER_SZ, "Error at PCD8544_draw_hline\n");
-            _screen_h->buffer[pos + i] |= common_mask;
-        }
+        memset(src, byte << dst->shift, sizeof(src));
+        _rop_span(dst->lo + (a - dst->ix0), b - a + 1, dst->m_lo, src, dst->rop);
     }
-    else
+
+    if(dst->hi)
     {
-        for(uint8_t i = 0; i < len; i++)
-        {
-            ASSERT_DEBUG((pos + i) >= LCDBUFFER_SZ, "Error at PCD8544_draw_hline\n");
-            _screen_h->buffer[pos + i] &= ~common_mask;
-        }
+        memset(src, byte >> (8 - dst->shift), sizeof(src));
+        _rop_span(dst->hi + (a - dst->ix0), b - a + 1, dst->m_hi, src, dst->rop);
     }
 }
 
 /*!
-    @brief    Draw a vertical line.
-    @param    x      Left-most x-coordinate
-    @param    y      Left-most y-coordinate
-    @param    len    The length of the line including the starting pixel
-    @param    color  Black(true)/white(false)
+    @brief    Draws a byte of a run-length encoded bitmap. Internal routine.
+    @param    dst      The destination of the current bank
+    @param    byte     The byte
+    @param    i        The column
 */
-void PCD8544_draw_vline(uint8_t x, uint8_t y, uint8_t len, bool color)
+static inline void _rle_byte(const _rle_dst_t *dst, uint8_t byte, uint8_t i)
 {
-    /* Sanity check - y value is taken care of by the loop conditions */
-    if(x >= LCDWIDTH || y >= LCDHEIGHT) return;
-
-    if(((uint16_t)y + len) >= LCDHEIGHT) len = LCDHEIGHT - y;
+    if(i < dst->ix0 || i > dst->ix1) return;
 
-    uint8_t byte_in = color ? 0xff : 0;
-    uint16_t pos = (y >> 3) * LCDWIDTH + x;
-    uint8_t temp = y & 0x07;
+    i -= dst->ix0;
+    if(dst->lo) dst->lo[i] = _rop_apply(dst->lo[i], dst->m_lo, byte << dst->shift, dst->rop);
+    if(dst->hi) dst->hi[i] = _rop_apply(dst->hi[i], dst->m_hi, byte >> (8 - dst->shift), dst->rop);
+}
 
-    /* Partial bank fill */
-    if(temp)
+/*!
+    @brief    Decodes the next bytes of a run-length encoded stream. Internal routine.
+    @param    st     The decoder state
+    @param    out    The output bytes
+    @param    n      The number of bytes
+*/
+static void _rle_read(_rle_stream_t *st, uint8_t *out, uint8_t n)
+{
+    while(n)
     {
-        ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at PCD8544_draw_vline\n");
-        uint8_t pixel_num = 8 - temp;
+        /* Next packet */
+        if(!st->len)
+        {
+            uint8_t header = *st->data++;
+            st->run = header & PCD8544_RLE_RUN;
+            st->len = st->run ? (header & ~PCD8544_RLE_RUN) + 2 : header + 1;
+            if(st->run) st->byte = *st->data++;
+        }
 
-        if(len <= pixel_num) /* Sub-case that needs to be handled */
+        uint8_t piece = (n < st->len) ? n : st->len;
+
+        if(st->run) memset(out, st->byte, piece);
+        else
         {
-            pixel_num = len;
-            _set_pixels_msb2lsb(pos, pixel_num, color);
-            return;
+            memcpy(out, st->data, piece);
+            st->data += piece;
         }
 
-        _set_pixels_msb2lsb(pos, pixel_num, color);
-        pos += LCDWIDTH;
-        len -= pixel_num;
+        out += piece;
+        n -= piece;
+        st->len -= piece;
     }
+}
 
-    /* Number of complete banks to fill */
-    while(len >= 8)
-    {
-        ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at PCD8544_draw_vline\n");
-        _screen_h->buffer[pos] = byte_in;
-        pos += LCDWIDTH;
-        len -= 8;
-    }
+/*!
+    @brief    Sets the draw target and clips to the whole of it, the pushed clip rectangles are dropped.
+    Internal routine, no error checking performed.
+    @param    surface   The surface, NULL for the display buffer
+*/
+static void _set_target(const pcd_8544_surface_t *surface)
+{
+    if(surface) _screen_h->target = *surface;
+    else _screen_h->target = (pcd_8544_surface_t){ .buffer = _screen_h->buffer, .width = LCDWIDTH,
+                                                    .height = LCDHEIGHT, .stride = LCDWIDTH };
 
-    /* Draw leftovers */
-    if(len) _set_pixels_lsb2msb(pos, len, color);
+    _screen_h->clip = (pcd_8544_rect_t){ .x0 = 0, .x1 = TARGET_WIDTH - 1, .y0 = 0, .y1 = TARGET_HEIGHT - 1 };
+    _screen_h->clip_depth = 0;
 }
 
 /*!
-    @brief    Draw a generic line.
+    @brief    Draws a generic line. Internal routine, it uses Bresenhm's algorithm and is based on the implementation
+    by the Adafruit GFX library.
     @param    x0     Starting x-coordinate
     @param    x1     Ending x-coordinate
     @param    y0     Starting y-coordinate
     @param    y1     Ending y-coordinate
     @param    color  Black(true)/white(false)
 */
-void PCD8544_draw_line(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color)
+static void _draw_generic_line(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color)
 {
-    if(x0 == x1) /* Horizontal line -> Call optimized version */
-    {
-        if(y0 > y1) SWAP_VAR(y0, y1);
-
-        PCD8544_draw_vline(x0, y0, y1 - y0 + 1, color);
-    }
-    else if(y0 == y1) /* Vertical line -> Call optimized version */
-    {
-        if(x0 > x1) SWAP_VAR(x0, x1);
+    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
 
-        PCD8544_draw_hline(x0, y0, x1 - x0 + 1, color);
-    }
-    else /* General case */
+    if(steep)
     {
-        _draw_generic_line(x0, x1, y0, y1, color);
+        SWAP_VAR(x0, y0);
+        SWAP_VAR(x1, y1);
     }
-}
-
-/*!
-    @brief    Draw a rectangle.
-    @param    x0     Upper left x-coordinate
-    @param    x1     Lower right x-coordinate
-    @param    y0     Upper left y-coordinate
-    @param    y1     Lower right y-coordinate
-    @param    color  Black(true)/white(false)
-    @param    fill   If true also fill the rectangle with the specified color
-*/
-void PCD8544_draw_rectangle(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color, bool fill)
-{
-    /* Sanity check */
-    if(x0 >= LCDWIDTH || y0 >= LCDHEIGHT) return;
-
-    /* Just in case mistakes were made */
-    if(x0 > x1) SWAP_VAR(x0, x1);
-    if(y0 > y1) SWAP_VAR(y0, y1);
 
-    /* Set the line lengths */
-    uint8_t len_x = x1 - x0 + 1;
-    uint8_t len_y = y1 - y0 + 1;
-
-    if(!fill)
+    if(x0 > x1)
     {
-        /* Connect 4 lines together */
-        PCD8544_draw_hline(x0, y0, len_x, color);
-        PCD8544_draw_hline(x0, y1, len_x, color);
-        PCD8544_draw_vline(x0, y0, len_y, color);
-        PCD8544_draw_vline(x1, y0, len_y, color);
-        return;
+        SWAP_VAR(x0, x1);
+        SWAP_VAR(y0, y1);
     }
 
-    /* It's more efficient to use vertical lines to draw for filling.
-     * That's the case since fewer memory accesses and instructions happen (on average) */
-    if(((uint16_t)y0 + len_y) >= LCDHEIGHT) len_y = LCDHEIGHT - y0;
-    if(((uint16_t)x0 + len_x) >= LCDWIDTH) len_x = LCDWIDTH - x0;
-
-    uint8_t byte_in = color ? 0xff : 0;
-    uint16_t pos = (y0 >> 3) * LCDWIDTH + x0;
-    uint8_t temp = y0 & 0x07;
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx >> 1;
+    int16_t ystep = (y0 < y1) ? 1 : -1;
 
-    /* Partial bank fill */
-    if(temp)
+    for (; x0 <= x1; x0++)
     {
-        ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at PCD8544_draw_rectangle\n");
-        uint8_t pixel_num = 8 - temp;
-
-        if(len_y <= pixel_num) /* Sub-case that needs to be handled */
+        if(steep)
         {
-            pixel_num = len_y;
-            for(uint8_t i = 0; i < len_x; i++) _set_pixels_msb2lsb(pos + i, pixel_num, color);
-            return;
+            PCD8544_set_pixel(y0, x0, color);
+        }
+        else
+        {
+            PCD8544_set_pixel(x0, y0, color);
         }
 
-        for(uint8_t i = 0; i < len_x; i++) _set_pixels_msb2lsb(pos + i, pixel_num, color);
-        pos += LCDWIDTH;
-        len_y -= pixel_num;
-    }
-
-    /* Number of complete banks to fill */
-    while(len_y >= 8)
-    {
-        ASSERT_DEBUG(pos >= LCDBUFFER_SZ, "Error at PCD8544_draw_rectangle\n");
-        memset(_screen_h->buffer + pos, byte_in, len_x * sizeof(uint8_t));
-        pos += LCDWIDTH;
-        len_y -= 8;
-    }
-
-    /* Draw leftovers */
-    if(len_y)
-    {
-        for(uint8_t i = 0; i < len_x; i++) _set_pixels_lsb2msb(pos + i, len_y, color);
+        err -= dy;
+        if(err < 0)
+        {
+            y0 += ystep;
+            err += dx;
+        }
     }
 }
 
 /*!
-    @brief    Draws a triangle. Also taken by the Adafruit GFX library.
-    @param    x0     First x-coordinate
-    @param    x1     Second x-coordinate
-    @param    x2     Third x-coordinate
+    @brief    SPI transmission internal routine.
+    @param    data      The SPI packet buffer to be sent
+    @param    nb_data   The number of packets(bytes) to be sent
+    @param    type      Type of transmission, true for data else command.
+    @return             Success(True) or Failure(False) of the SPI transmission.
+*/
+static bool _send_packet(uint8_t *data, uint16_t nb_data , bool type)
+{
+    HAL_StatusTypeDef ret;
+
+    /* Data needs DC high - Command needs DC low */
+    type ? SET_GPIO(_screen_h->dc_port, _screen_h->dc_pin) \
+         : RESET_GPIO(_screen_h->dc_port, _screen_h->dc_pin);
+
+    /* Chip enable - Active Low */
+    RESET_GPIO(_screen_h->ce_port, _screen_h->ce_pin);
+
+    #ifdef PCD8544_DMA_ACTIVE
+        /* Set handler flag */
+        _screen_h->dma_transfer = true;
+
+        /* Transmit through SPI using DMA */
+        ret = HAL_SPI_Transmit_DMA(_screen_h->h_spi, data, nb_data);
+    #else
+        /* Transmit through SPI */
+        ret = HAL_SPI_Transmit(_screen_h->h_spi, data, nb_data, SPI_TIMEOUT);
+
+        /* Chip disable - Active Low */
+        SET_GPIO(_screen_h->ce_port, _screen_h->ce_pin);
+    #endif
+
+    return ret == HAL_OK;
+}
+
+/*!
+    @brief    Waits for the previous SPI transmission to finish. Only DMA transfers can be pending.
+*/
+static void _wait_transfer()
+{
+    #ifdef PCD8544_DMA_ACTIVE
+        while(_screen_h->dma_transfer);
+    #endif
+}
+
+/*!
+    @brief    Tells whether the greyscale tick owns the display. It starts its frames on its own,
+    so any other transfer would interleave with them and move the display RAM address.
+    @return   True while the temporal greyscale mode is on.
+*/
+static bool _grey_active()
+{
+    return _screen_h->grey != NULL;
+}
+
+/*!
+    @brief    Creates the initialization command sequence for the screen.
+    @param    command_buffer  The buffer to write the commands in
+*/
+static void _init_sequence(uint8_t *command_buffer)
+{
+    command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION;     /* Enter extended instruction mode */
+    command_buffer[1] = PCD8544_SETBIAS | _screen_h->bias;                     /* Set bias voltage */
+    command_buffer[2] = PCD8544_SETVOP | _screen_h->contast;                   /* Set contrast */
+    command_buffer[3] = PCD8544_FUNCTIONSET;                                   /* Enter normal instruction mode - Vertical display */
+    command_buffer[4] = PCD8544_SETXADDR | 0;                                  /* Initialize coordinates */
+    command_buffer[5] = PCD8544_SETYADDR | 0;                                  /* Initialize coordinates */
+    command_buffer[6] = PCD8544_DISPLAYCONTROL | PCD8544_DISPLAYNORMAL;        /* Set display to normal */
+}
+
+/**********************************************************/
+/************************ OPERATIONS **********************/
+/**********************************************************/
+
+/*!
+    @brief    Initializes the display and the library with a new handle.
+    @return   Success(True) or Failure(False) of the procedure.
+*/
+bool PCD8544_init(pcd_8544_t *init)
+{
+    ASSERT_DEBUG(init == NULL, "Null pointer - PCD8544_init()\n");
+
+    /* Initialize the screen handle - The greyscale tick can run from now on */
+    init->grey = NULL;
+    _screen_h = init;
+
+    /* Chip enable initialization - Active low */
+    SET_GPIO(_screen_h->ce_port, _screen_h->ce_pin);
+
+    /* We reset for 2ms - Active low */
+    RESET_GPIO(_screen_h->rst_port, _screen_h->rst_pin);
+    HAL_Delay(2);
+    SET_GPIO(_screen_h->rst_port, _screen_h->rst_pin);
+
+    /* Sanity check for contrast-bias values */
+    if(_screen_h->contast > 0x7f) _screen_h->contast = 0x7f;
+    if(_screen_h->bias > 0x07) _screen_h->bias = 0x07;
+
+    /* Initialize the cursor for the text printer */
+    _screen_h->x_pos = _screen_h->y_pos = 0;
+
+    /* Drawing overwrites the buffer by default */
+    _screen_h->rop = PCD8544_ROP_COPY;
+
+    /* Draw on the display buffer, clipped to the whole screen */
+    _set_target(NULL);
+
+    /* Solid fills */
+    _screen_h->pattern = NULL;
+
+    #ifndef PCD8544_DMA_ACTIVE
+        /* Polling transfer - Allocate the buffer on the stack */
+        uint8_t command_buffer[7];
+    #else
+        /* Set DMA transfer flag */
+        _screen_h->dma_transfer = false;
+    #endif
+
+    /* List the base commands */
+    _init_sequence(command_buffer);
+
+    /* Send the base commands and return code */
+    return _send_packet(command_buffer, 7, false);
+}
+
+/*!
+    @brief    Swaps the current screen handle.
+    This is used to change the current screen that the library sends commands and updates
+    graphics into. Initialization for the new screen is the user's responsibility.
+    @param    new  The new screen handle
+    @return        The old display's handle
+*/
+pcd_8544_t *PCD8544_handle_swap(pcd_8544_t *new)
+{
+    ASSERT_DEBUG(new != NULL, "Null pointer - PCD8544_handle_swap()\n");
+
+    pcd_8544_t *old = _screen_h;
+    _screen_h = new;
+
+    return old;
+}
+
+/*!
+    @brief    Draws the contents of the buffer on the display.
+    @return   Success(True) or Failure(False) in sending the data.
+*/
+bool PCD8544_refresh()
+{
+    if(_grey_active()) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        if(_screen_h->dma_transfer) return false;
+    #endif
+
+    /* Draw and return */
+    return _send_packet(_screen_h->buffer, LCDBUFFER_SZ, true);
+}
+
+/*!
+    @brief    Draws part of the buffer on the display. The region is extended to whole banks
+    vertically. Each bank needs its own address command, unless the region spans the whole width.
+    The RAM address is set back to the origin afterwards, so PCD8544_refresh() keeps working.
+    With DMA, this waits for the previous transfer and between the packets.
+    @param    x0     Left-most x-coordinate
+    @param    x1     Right-most x-coordinate
+    @param    y0     Uppermost y-coordinate
+    @param    y1     Lowermost y-coordinate
+    @return          Success(True) or Failure(False) in sending the data.
+*/
+bool PCD8544_refresh_region(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    /* Just in case mistakes were made */
+    if(x0 > x1) SWAP_VAR(x0, x1);
+    if(y0 > y1) SWAP_VAR(y0, y1);
+
+    /* Sanity check */
+    if(_grey_active()) return false;
+    if(x0 >= LCDWIDTH || y0 >= LCDHEIGHT) return true;
+    if(x1 >= LCDWIDTH) x1 = LCDWIDTH - 1;
+    if(y1 >= LCDHEIGHT) y1 = LCDHEIGHT - 1;
+
+    #ifndef PCD8544_DMA_ACTIVE
+        /* Polling transfer - Allocate the buffer on the stack */
+        uint8_t command_buffer[2];
+    #endif
+
+    uint8_t bank0 = y0 >> 3, bank1 = y1 >> 3;
+    uint8_t len_x = x1 - x0 + 1;
+
+    /* Full rows are contiguous in the display RAM - A single packet is enough */
+    uint8_t packets = (len_x == LCDWIDTH) ? 1 : bank1 - bank0 + 1;
+    uint16_t packet_sz = (len_x == LCDWIDTH) ? (bank1 - bank0 + 1) * LCDWIDTH : len_x;
+    bool ret = true;
+
+    for(uint8_t i = 0; i < packets && ret; i++)
+    {
+        _wait_transfer();
+        command_buffer[0] = PCD8544_SETYADDR | (bank0 + i);
+        command_buffer[1] = PCD8544_SETXADDR | x0;
+        ret = _send_packet(command_buffer, 2, false);
+
+        _wait_transfer();
+        ret = ret && _send_packet(_screen_h->buffer + (bank0 + i) * LCDWIDTH + x0, packet_sz, true);
+    }
+
+    /* Back to the origin for the full refresh */
+    _wait_transfer();
+    command_buffer[0] = PCD8544_SETYADDR | 0;
+    command_buffer[1] = PCD8544_SETXADDR | 0;
+
+    return _send_packet(command_buffer, 2, false) && ret;
+}
+
+/*!
+    @brief    Draws a full screen run-length encoded frame (see PCD8544_RLE_RUN) on the display,
+    without going through the buffer, which is left untouched. The frame is decoded in chunks of
+    32 bytes, alternating between two chunk buffers, so with DMA the next chunk is decoded while
+    the previous one is sent. Only 64 bytes of RAM are used, e.g. for splash screens and static pages.
+    @param    data   The encoded frame, PCD8544_BUFFER_SZ bytes once decoded
+    @return          Success(True) or Failure(False) in sending the data.
+*/
+bool PCD8544_refresh_rle(const uint8_t *data)
+{
+    /* Sanity check */
+    if(!data || _grey_active()) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        if(_screen_h->dma_transfer) return false;
+    #else
+        /* Polling transfer - Each chunk is sent before the next one is decoded */
+        uint8_t stream_buffer[2][STREAM_CHUNK_SZ];
+    #endif
+
+    _rle_stream_t st = { .data = data, .len = 0 };
+    bool ret = true;
+
+    /* The display RAM address is at the origin, it advances with every byte sent */
+    for(uint16_t pos = 0, k = 0; pos < LCDBUFFER_SZ && ret; pos += STREAM_CHUNK_SZ, k ^= 1)
+    {
+        uint8_t n = (LCDBUFFER_SZ - pos < STREAM_CHUNK_SZ) ? LCDBUFFER_SZ - pos : STREAM_CHUNK_SZ;
+        _rle_read(&st, stream_buffer[k], n);
+
+        _wait_transfer();
+        ret = _send_packet(stream_buffer[k], n, true);
+    }
+
+    return ret;
+}
+
+/*!
+    @brief    Draws a viewport of a canvas, a surface larger than the screen, on the display.
+    Panning is just a change of the viewport's origin, the canvas is not redrawn.
+    When y is a multiple of 8, every bank of the viewport is sent straight out of the canvas
+    (the display RAM wraps to the next bank after the last column). Otherwise, the banks are
+    shifted together into the display buffer first, overwriting it, and sent as a whole.
+    @param    canvas   The canvas, at least as large as the screen
+    @param    x        Left-most x-coordinate of the viewport, clamped inside the canvas
+    @param    y        Uppermost y-coordinate of the viewport, clamped inside the canvas
+    @return            Success(True) or Failure(False) in sending the data.
+*/
+bool PCD8544_refresh_view(const pcd_8544_surface_t *canvas, uint8_t x, uint8_t y)
+{
+    /* Sanity check */
+    if(!canvas || _grey_active() || !canvas->buffer || canvas->width < LCDWIDTH || canvas->height < LCDHEIGHT) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        if(_screen_h->dma_transfer) return false;
+    #endif
+
+    if(x > canvas->width - LCDWIDTH) x = canvas->width - LCDWIDTH;
+    if(y > canvas->height - LCDHEIGHT) y = canvas->height - LCDHEIGHT;
+
+    const uint8_t *src = canvas->buffer + (y >> 3) * canvas->stride + x;
+    uint8_t shift = y & 0x07;
+
+    /* Aligned - Zero-copy, a single packet when the canvas rows are contiguous */
+    if(!shift)
+    {
+        if(canvas->stride == LCDWIDTH) return _send_packet((uint8_t *)src, LCDBUFFER_SZ, true);
+
+        bool ret = true;
+        for(uint8_t bank = 0; bank < LCDHEIGHT/8 && ret; bank++)
+        {
+            _wait_transfer();
+            ret = _send_packet((uint8_t *)src + bank * canvas->stride, LCDWIDTH, true);
+        }
+
+        return ret;
+    }
+
+    /* Unaligned - Each bank is the lower rows of a canvas bank and the upper rows of the next */
+    uint8_t *dst = _screen_h->buffer;
+    for(uint8_t bank = 0; bank < LCDHEIGHT/8; bank++)
+    {
+        const uint8_t *lo = src + bank * canvas->stride, *hi = lo + canvas->stride;
+
+        for(uint8_t i = 0; i < LCDWIDTH; i++) *dst++ = (lo[i] >> shift) | (hi[i] << (8 - shift));
+    }
+
+    return _send_packet(_screen_h->buffer, LCDBUFFER_SZ, true);
+}
+
+/*!
+    @brief    Fills the draw target (the display buffer by default) with the specified color.
+    @param    color  Fill with black(true) or with white(false).
+*/
+void PCD8544_fill(bool color)
+{
+    memset(TARGET_BUFFER, color ? 0xff : 0, TARGET_SZ * sizeof(uint8_t));
+}
+
+/*!
+    @brief    Inverts or uninverts the display.
+    @param    invert  True(Invert) and False(Uninvert).
+    @return           Success(True) or Failure(False) in sending the command.
+*/
+bool PCD8544_invert(bool invert)
+{
+    if(_grey_active()) return false;
+
+#ifdef PCD8544_DMA_ACTIVE
+    /* DMA transfer - Make sure transfer is finished */
+    if(_screen_h->dma_transfer) return false;
+#else
+    /* Polling transfer - Allocate the buffer on the stack */
+    uint8_t command_buffer[3];
+#endif
+
+    /* Commands for inversion */
+    command_buffer[0] = PCD8544_FUNCTIONSET;
+    command_buffer[1] = PCD8544_DISPLAYCONTROL | (invert ? PCD8544_DISPLAYINVERTED: PCD8544_DISPLAYNORMAL);
+    command_buffer[2] = PCD8544_FUNCTIONSET;
+
+    return _send_packet(command_buffer, 3, false);
+}
+
+/*!
+    @brief    Enables or disables sleep mode.
+    @param    enable  Enable(true) sleep mode or disable(false).
+    @return           Success(True) or Failure(False) in sending the command.
+*/
+bool PCD8544_sleep_mode(bool enable)
+{
+    if(_grey_active()) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        /* DMA transfer - Make sure transfer is finished */
+        if(_screen_h->dma_transfer) return false;
+    #else
+        /* Polling transfer - Allocate the buffer on the stack */
+        uint8_t command_buffer[7];
+    #endif
+
+    if(enable) /* Buffer and settings are saved */
+    {
+        command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_POWERDOWN;
+        return _send_packet(command_buffer, 1, false);
+    }
+
+    /* Repeat basic initialization */
+    _init_sequence(command_buffer);
+
+    return _send_packet(command_buffer, 7, false);
+}
+
+/*!
+    @brief    Set display's contrast value.
+    @param    contrast  The contrast value.
+    @return             Success(True) or Failure(False) in sending the command.
+*/
+bool PCD8544_contrast(uint8_t contrast)
+{
+    if(_grey_active()) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        /* DMA transfer - Make sure transfer is finished */
+        if(_screen_h->dma_transfer) return false;
+    #else
+        /* Polling transfer - Allocate the buffer on the stack */
+        uint8_t command_buffer[3];
+    #endif
+
+    /* Update contrast value */
+    _screen_h->contast = (contrast < 0x7f) ? contrast : 0x7f;
+
+    command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION;
+    command_buffer[1] = PCD8544_SETVOP | _screen_h->contast;
+    command_buffer[2] = PCD8544_FUNCTIONSET;
+
+    return _send_packet(command_buffer, 3, false);
+}
+
+/*!
+    @brief    Set display's bias value.
+    @param    bias  The bias value.
+    @return         Success(True) or Failure(False) in sending the command.
+*/
+bool PCD8544_bias(uint8_t bias)
+{
+    if(_grey_active()) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        /* DMA transfer - Make sure transfer is finished */
+        if(_screen_h->dma_transfer) return false;
+    #else
+        /* Polling transfer - Allocate the buffer on the stack */
+        uint8_t command_buffer[3];
+    #endif
+
+    /* Update bias value */
+    _screen_h->bias = (bias < 0x07) ? bias : 0x07;
+
+    command_buffer[0] = PCD8544_FUNCTIONSET | PCD8544_EXTENDEDINSTRUCTION;
+    command_buffer[1] = PCD8544_SETBIAS | _screen_h->bias;
+    command_buffer[2] = PCD8544_FUNCTIONSET;
+
+    return _send_packet(command_buffer, 3, false);
+}
+
+/*!
+    @brief    Sets the raster operation used by all drawing routines (shapes, bitmaps and text).
+    For example, with PCD8544_ROP_XOR a shape drawn twice is erased and the contents under it restored.
+    @param    rop  The raster operation (PCD8544_ROP_COPY, _OR, _XOR, _ANDNOT or _AND)
+    @return        The previous raster operation
+*/
+uint8_t PCD8544_rop(uint8_t rop)
+{
+    uint8_t old = _screen_h->rop;
+    if(rop <= PCD8544_ROP_AND) _screen_h->rop = rop;
+
+    return old;
+}
+
+/*!
+    @brief    Pushes a clip rectangle. All drawing routines are limited to the intersection
+    of this rectangle with the current clip rectangle, until it is popped.
+    @param    x0     Left-most x-coordinate
+    @param    x1     Right-most x-coordinate
+    @param    y0     Uppermost y-coordinate
+    @param    y1     Lowermost y-coordinate
+    @return          Success(True) or Failure(False) if the stack is full.
+*/
+bool PCD8544_clip_push(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    if(_screen_h->clip_depth >= PCD8544_CLIP_DEPTH) return false;
+
+    /* Just in case mistakes were made */
+    if(x0 > x1) SWAP_VAR(x0, x1);
+    if(y0 > y1) SWAP_VAR(y0, y1);
+
+    pcd_8544_rect_t *clip = &_screen_h->clip;
+    _screen_h->clip_stack[_screen_h->clip_depth++] = *clip;
+
+    /* Intersect - An empty result (x0 > x1 or y0 > y1) rejects everything */
+    if(x0 > clip->x0) clip->x0 = x0;
+    if(x1 < clip->x1) clip->x1 = x1;
+    if(y0 > clip->y0) clip->y0 = y0;
+    if(y1 < clip->y1) clip->y1 = y1;
+
+    return true;
+}
+
+/*!
+    @brief    Pops the last pushed clip rectangle and restores the previous one.
+    @return   Success(True) or Failure(False) if the stack is empty.
+*/
+bool PCD8544_clip_pop()
+{
+    if(!_screen_h->clip_depth) return false;
+
+    _screen_h->clip = _screen_h->clip_stack[--_screen_h->clip_depth];
+
+    return true;
+}
+
+/*!
+    @brief    Saves the drawing state (draw target, clip rectangles, raster operation and pattern)
+    and resets it: the display buffer is the target, clipped to the whole screen, with COPY and solid fills.
+    Meant for code that redraws parts of the screen on its own, like the sprite pool, so that the
+    application's settings neither leak into it nor are lost.
+    @param    state    The saved state, for PCD8544_state_restore()
+*/
+void PCD8544_state_save(pcd_8544_state_t *state)
+{
+    state->target = _screen_h->target;
+    state->clip = _screen_h->clip;
+    memcpy(state->clip_stack, _screen_h->clip_stack, sizeof(state->clip_stack));
+    state->clip_depth = _screen_h->clip_depth;
+    state->rop = _screen_h->rop;
+    state->pattern = _screen_h->pattern;
+
+    _set_target(NULL);
+    _screen_h->rop = PCD8544_ROP_COPY;
+    _screen_h->pattern = NULL;
+}
+
+/*!
+    @brief    Restores a drawing state saved with PCD8544_state_save().
+    @param    state    The saved state
+*/
+void PCD8544_state_restore(const pcd_8544_state_t *state)
+{
+    _screen_h->target = state->target;
+    _screen_h->clip = state->clip;
+    memcpy(_screen_h->clip_stack, state->clip_stack, sizeof(_screen_h->clip_stack));
+    _screen_h->clip_depth = state->clip_depth;
+    _screen_h->rop = state->rop;
+    _screen_h->pattern = state->pattern;
+}
+
+/*!
+    @brief    Sets the stipple pattern used by the filled shapes (rectangles, circles, triangles and polygons).
+    Byte i of the pattern is the column used for x mod 8 == i, with the LSB being the top row (y mod 8 == 0).
+    Set bits are drawn with the shape's color and cleared bits with the opposite one, so the raster
+    operation sees the pattern when drawing black and the inverted pattern when drawing white.
+    With COPY the whole area is overwritten, while OR, XOR and ANDNOT act on the set bits of the
+    pattern when drawing black and on its cleared bits when drawing white.
+    The pattern is not copied, so it must stay valid while in use.
+    @param    pattern  The 8 byte pattern, or NULL for solid fills
+    @return            The previous pattern
+*/
+const uint8_t *PCD8544_pattern(const uint8_t *pattern)
+{
+    const uint8_t *old = _screen_h->pattern;
+    _screen_h->pattern = pattern;
+
+    return old;
+}
+
+/*!
+    @brief    Returns one of the predefined hatch patterns, to be passed to PCD8544_pattern().
+    @param    style  The hatch style (PCD8544_HATCH_HORIZONTAL, _VERTICAL, _DIAGONAL, ...)
+    @return          The pattern or NULL if the style is invalid
+*/
+const uint8_t *PCD8544_hatch(uint8_t style)
+{
+    if(style >= sizeof(_hatch_patterns) / sizeof(_hatch_patterns[0])) return NULL;
+
+    return _hatch_patterns[style];
+}
+
+/*!
+    @brief    Generates a grey level pattern using an 8x8 ordered dither (Bayer) matrix.
+    @param    level    The grey level, from 0(white) to PCD8544_GREY_LEVELS(black)
+    @param    pattern  The 8 byte output pattern, to be passed to PCD8544_pattern()
+*/
+void PCD8544_pattern_grey(uint8_t level, uint8_t *pattern)
+{
+    for(uint8_t x = 0; x < 8; x++)
+    {
+        uint8_t column = 0;
+        for(uint8_t y = 0; y < 8; y++)
+            if(bayer_8x8[y][x] < level) column |= 1 << y;
+
+        pattern[x] = column;
+    }
+}
+
+/**********************************************************/
+/************************ GRAPHICS ************************/
+/**********************************************************/
+
+/*!
+    @brief    Set a pixel's value.
+    @param    x       x-coordinate
+    @param    y       y-coordinate
+    @param    color   Black(true) or white(false)
+*/
+void PCD8544_set_pixel(uint8_t x, uint8_t y, bool color)
+{
+    /* Sanity check */
+    if(!_in_clip(x, y)) return;
+
+    /* Call the internal routine */
+    _set_single_pixel(x, y, color);
+}
+
+/*!
+    @brief    Returns a pixel's value.
+    @param    x   x-coordinate
+    @param    y   y-coordinate
+    @return       In case of error, 0xFF is returned, otherwise true or false.
+*/
+uint8_t PCD8544_get_pixel(uint8_t x, uint8_t y)
+{
+    /* Return max value in case of failure */
+    return ((x >= TARGET_WIDTH) || (y >= TARGET_HEIGHT)) ? 0xff : _get_single_pixel(x, y);
+}
+
+/*!
+    @brief    Draw a horizontal line.
+    @param    x      Left-most x-coordinate
+    @param    y      Left-most y-coordinate
+    @param    len    The length of the line including the starting pixel
+    @param    color  Black(true)/white(false)
+*/
+void PCD8544_draw_hline(uint8_t x, uint8_t y, uint8_t len, bool color)
+{
+    if(!len) return;
+
+    int16_t x0 = x, x1 = (int16_t)x + len - 1, y0 = y, y1 = y;
+    if(!_clip_rect(&x0, &x1, &y0, &y1)) return;
+
+    uint16_t pos = (y0 >> 3) * TARGET_STRIDE + x0;
+    len = x1 - x0 + 1;
+    ASSERT_DEBUG((pos + len) > TARGET_SZ, "Error at PCD8544_draw_hline\n");
+
+    /* A single row of the bank - Word-wide OR/AND with the replicated mask */
+    _rop_span(TARGET_BUFFER + pos, len, 1 << (y0 & 0x07), color ? _solid_pattern : _clear_pattern, _screen_h->rop);
+}
+
+/*!
+    @brief    Draw a vertical line.
+    @param    x      Left-most x-coordinate
+    @param    y      Left-most y-coordinate
+    @param    len    The length of the line including the starting pixel
+    @param    color  Black(true)/white(false)
+*/
+void PCD8544_draw_vline(uint8_t x, uint8_t y, uint8_t len, bool color)
+{
+    if(!len) return;
+
+    int16_t x0 = x, x1 = x, y0 = y, y1 = (int16_t)y + len - 1;
+    if(!_clip_rect(&x0, &x1, &y0, &y1)) return;
+
+    _fill_block(x0, x1, y0, y1, color, NULL);
+}
+
+/*!
+    @brief    Draw a generic line.
+    @param    x0     Starting x-coordinate
+    @param    x1     Ending x-coordinate
+    @param    y0     Starting y-coordinate
+    @param    y1     Ending y-coordinate
+    @param    color  Black(true)/white(false)
+*/
+void PCD8544_draw_line(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color)
+{
+    if(x0 == x1) /* Horizontal line -> Call optimized version */
+    {
+        if(y0 > y1) SWAP_VAR(y0, y1);
+
+        PCD8544_draw_vline(x0, y0, y1 - y0 + 1, color);
+    }
+    else if(y0 == y1) /* Vertical line -> Call optimized version */
+    {
+        if(x0 > x1) SWAP_VAR(x0, x1);
+
+        PCD8544_draw_hline(x0, y0, x1 - x0 + 1, color);
+    }
+    else if(_bbox_visible(x0, x1, y0, y1)) /* General case */
+    {
+        _draw_generic_line(x0, x1, y0, y1, color);
+    }
+}
+
+/*!
+    @brief    Draw a rectangle.
+    @param    x0     Upper left x-coordinate
+    @param    x1     Lower right x-coordinate
+    @param    y0     Upper left y-coordinate
+    @param    y1     Lower right y-coordinate
+    @param    color  Black(true)/white(false)
+    @param    fill   If true also fill the rectangle with the specified color
+*/
+void PCD8544_draw_rectangle(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color, bool fill)
+{
+    /* Just in case mistakes were made */
+    if(x0 > x1) SWAP_VAR(x0, x1);
+    if(y0 > y1) SWAP_VAR(y0, y1);
+
+    /* Sanity check */
+    if(!_bbox_visible(x0, x1, y0, y1)) return;
+
+    /* Set the line lengths */
+    uint8_t len_x = x1 - x0 + 1;
+    uint8_t len_y = y1 - y0 + 1;
+
+    if(!fill)
+    {
+        /* Connect 4 lines together - Corners are drawn once, so XOR outlines stay intact */
+        PCD8544_draw_hline(x0, y0, len_x, color);
+        if(len_y > 1) PCD8544_draw_hline(x0, y1, len_x, color);
+
+        if(len_y > 2)
+        {
+            PCD8544_draw_vline(x0, y0 + 1, len_y - 2, color);
+            if(len_x > 1) PCD8544_draw_vline(x1, y0 + 1, len_y - 2, color);
+        }
+        return;
+    }
+
+    int16_t cx0 = x0, cx1 = x1, cy0 = y0, cy1 = y1;
+    if(_clip_rect(&cx0, &cx1, &cy0, &cy1)) _fill_block(cx0, cx1, cy0, cy1, color, _screen_h->pattern);
+}
+
+/*!
+    @brief    Inverts a rectangular region of the buffer, regardless of the raster operation.
+    Handy for highlighting a selected menu entry. Inverting the same region again restores it.
+    @param    x0     Upper left x-coordinate
+    @param    x1     Lower right x-coordinate
+    @param    y0     Upper left y-coordinate
+    @param    y1     Lower right y-coordinate
+*/
+void PCD8544_invert_rect(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    /* Just in case mistakes were made */
+    if(x0 > x1) SWAP_VAR(x0, x1);
+    if(y0 > y1) SWAP_VAR(y0, y1);
+
+    int16_t cx0 = x0, cx1 = x1, cy0 = y0, cy1 = y1;
+    if(!_clip_rect(&cx0, &cx1, &cy0, &cy1)) return;
+
+    uint16_t pos = (cy0 >> 3) * TARGET_STRIDE + cx0;
+    for(uint8_t bank = cy0 >> 3; bank <= (cy1 >> 3); bank++)
+    {
+        ASSERT_DEBUG(pos >= TARGET_SZ, "Error at PCD8544_invert_rect\n");
+        _rop_span(TARGET_BUFFER + pos, cx1 - cx0 + 1, _bank_mask(bank, cy0, cy1), _solid_pattern, PCD8544_ROP_XOR);
+        pos += TARGET_STRIDE;
+    }
+}
+
+/*!
+    @brief    Scrolls a region of the buffer in place, by any number of pixels in both directions.
+    Columns are moved with memmove and rows are shifted across the banks, so this is much
+    cheaper than drawing the contents again. The raster operation and pattern are ignored.
+    @param    x0        Left-most x-coordinate
+    @param    x1        Right-most x-coordinate
+    @param    y0        Uppermost y-coordinate
+    @param    y1        Lowermost y-coordinate
+    @param    dx        Horizontal distance, positive to the right
+    @param    dy        Vertical distance, positive downwards
+    @param    exposed   What the exposed area becomes (PCD8544_SCROLL_KEEP, _WHITE or _BLACK)
+*/
+void PCD8544_scroll(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, int8_t dx, int8_t dy, uint8_t exposed)
+{
+    /* Just in case mistakes were made */
+    if(x0 > x1) SWAP_VAR(x0, x1);
+    if(y0 > y1) SWAP_VAR(y0, y1);
+
+    int16_t cx0 = x0, cx1 = x1, cy0 = y0, cy1 = y1;
+    if(!_clip_rect(&cx0, &cx1, &cy0, &cy1)) return;
+
+    _scroll_horizontal(cx0, cx1, cy0, cy1, dx);
+    _scroll_vertical(cx0, cx1, cy0, cy1, dy);
+
+    if(exposed != PCD8544_SCROLL_WHITE && exposed != PCD8544_SCROLL_BLACK) return;
+
+    /* Clear the exposed columns and rows - Distances beyond the region expose all of it */
+    bool color = exposed == PCD8544_SCROLL_BLACK;
+    uint8_t rop = _screen_h->rop;
+    _screen_h->rop = PCD8544_ROP_COPY;
+
+    if(dx)
+    {
+        int16_t ex0 = (dx > 0) ? cx0 : cx1 + dx + 1, ex1 = (dx > 0) ? cx0 + dx - 1 : cx1;
+        _fill_block((ex0 < cx0) ? cx0 : ex0, (ex1 > cx1) ? cx1 : ex1, cy0, cy1, color, NULL);
+    }
+
+    if(dy)
+    {
+        int16_t ey0 = (dy > 0) ? cy0 : cy1 + dy + 1, ey1 = (dy > 0) ? cy0 + dy - 1 : cy1;
+        _fill_block(cx0, cx1, (ey0 < cy0) ? cy0 : ey0, (ey1 > cy1) ? cy1 : ey1, color, NULL);
+    }
+
+    _screen_h->rop = rop;
+}
+
+/*!
+    @brief    Draws a triangle. Also taken by the Adafruit GFX library.
+    @param    x0     First x-coordinate
+    @param    x1     Second x-coordinate
+    @param    x2     Third x-coordinate
+    @param    y0     First y-coordinate
+    @param    y1     Second y-coordinate
+    @param    y2     Third y-coordinate
+    @param    color  Black(true)/white(false)
+*/
+void PCD8544_draw_triangle(uint8_t x0, uint8_t x1, uint8_t x2, uint8_t y0, uint8_t y1, uint8_t y2, bool color)
+{
+    PCD8544_draw_line(x0, x1, y0, y1, color);
+    PCD8544_draw_line(x1, x2, y1, y2, color);
+    PCD8544_draw_line(x0, x2, y0, y2, color);
+}
+
+/*!
+    @brief    Draws a filled triangle. Also taken by the Adafruit GFX library.
+    @param    x0     First x-coordinate
+    @param    x1     Second x-coordinate
+    @param    x2     Third x-coordinate
     @param    y0     First y-coordinate
     @param    y1     Second y-coordinate
     @param    y2     Third y-coordinate
+    @param    color  Triangle color, Black(true)/white(false)
+*/
+void PCD8544_draw_fill_triangle(uint8_t x0, uint8_t x1, uint8_t x2, uint8_t y0, uint8_t y1, uint8_t y2, bool color)
+{
+    uint8_t a, b, y, last;
+
+    /* Sort coordinates by Y order (y2 >= y1 >= y0) */
+    if (y0 > y1)
+    {
+        SWAP_VAR(y0, y1);
+        SWAP_VAR(x0, x1);
+    }
+
+    if (y1 > y2)
+    {
+        SWAP_VAR(y2, y1);
+        SWAP_VAR(x2, x1);
+    }
+
+    if (y0 > y1)
+    {
+        SWAP_VAR(y0, y1);
+        SWAP_VAR(x0, x1);
+    }
+
+    /* Nothing to draw inside the clip rectangle */
+    a = (x0 < x1) ? x0 : x1;
+    b = (x0 < x1) ? x1 : x0;
+    if(!_bbox_visible((x2 < a) ? x2 : a, (x2 > b) ? x2 : b, y0, y2)) return;
+
+    /* Handle awkward all-on-same-line case as its own thing */
+    if(y0 == y2)
+    {
+        a = b = x0;
+        if (x1 < a)       a = x1;
+        else if (x1 > b)  b = x1;
+
+        if (x2 < a)       a = x2;
+        else if (x2 > b)  b = x2;
+
+        _fill_hspan(a, b, y0, color);
+        return;
+    }
+
+    uint8_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0,
+            dx12 = x2 - x1, dy12 = y2 - y1;
+    uint16_t sa = 0, sb = 0;
+
+    /* For upper part of triangle, find scanline crossings for segments 0-1 and 0-2.
+     * If y1=y2 (flat-bottomed triangle), the scanline y1
+     * is included here (and second loop will be skipped, avoiding a /0
+     * error there), otherwise scanline y1 is skipped here and handled
+     * in the second loop...which also avoids a /0 error here if y0=y1
+     * (flat-topped triangle).
+     */
+
+    /* Include y1 scanline(?) or skip it(:) */
+    last = (y1 == y2) ? y1 : (y1 - 1);
+
+    for (y = y0; y <= last; y++)
+    {
+        a = x0 + sa / dy01;
+        b = x0 + sb / dy02;
+        sa += dx01;
+        sb += dx02;
+        /* longhand:
+        a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+        b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
+        */
+        if (a > b) SWAP_VAR(a, b);
+        _fill_hspan(a, b, y, color);
+    }
+
+    /* For lower part of triangle, find scanline crossings for segments
+     * 0-2 and 1-2.  This loop is skipped if y1=y2.
+     */
+    sa = (uint16_t)dx12 * (y - y1);
+    sb = (uint16_t)dx02 * (y - y0);
+    for (; y <= y2; y++)
+    {
+        a = x1 + sa / dy12;
+        b = x0 + sb / dy02;
+        sa += dx12;
+        sb += dx02;
+        /* longhand:
+        a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
+        b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
+        */
+        if (a > b) SWAP_VAR(a, b);
+        _fill_hspan(a, b, y, color);
+    }
+}
+
+/*!
+    @brief    Draws a circle - Uses the Midpoint circle algorithm.
+    @param    x0   Center x-coordinate
+    @param    y0   Center y-coordinate
+    @param    r    Circle radius
+    @param    color - black(true)/white(false)
+*/
+void PCD8544_draw_circle(uint8_t x, uint8_t y, uint8_t r, bool color)
+{
+    /* Nothing to draw inside the clip rectangle */
+    if(!_bbox_visible((int16_t)x - r, (int16_t)x + r, (int16_t)y - r, (int16_t)y + r)) return;
+
+    if(!r)
+    {
+        PCD8544_set_pixel(x, y, color);
+        return;
+    }
+
+    /* Points on the axes, then the rest of the octants */
+    _set_pixel_clip(x, (int16_t)y - r, color);
+    _set_pixel_clip(x, (int16_t)y + r, color);
+    _set_pixel_clip((int16_t)x - r, y, color);
+    _set_pixel_clip((int16_t)x + r, y, color);
+    _draw_circle_arcs(x, x, y, y, r, color);
+}
+
+/*!
+    @brief    Draws a filled circle - Uses the Midpoint circle algorithm.
+    @param    x0   Center x-coordinate
+    @param    y0   Center y-coordinate
+    @param    r    Circle radius
+    @param    color - black(true)/white(false)
+*/
+void PCD8544_draw_fill_circle(uint8_t x0, uint8_t y0, uint8_t r, bool color)
+{
+    /* Nothing to draw inside the clip rectangle */
+    if(!_bbox_visible((int16_t)x0 - r, (int16_t)x0 + r, (int16_t)y0 - r, (int16_t)y0 + r)) return;
+
+    /* Write out the middle line - Spans are clipped, so they can be out of bounds */
+    _fill_vspan(x0, (int16_t)y0 - r, (int16_t)y0 + r, color);
+    _fill_circle_spans(x0, x0, y0, y0, r, color);
+}
+
+/*!
+    @brief    Draw a rounded rectangle. The corners are quarter circles and the straight
+    part is filled bank-wise, like PCD8544_draw_rectangle().
+    @param    x0     Upper left x-coordinate
+    @param    x1     Lower right x-coordinate
+    @param    y0     Upper left y-coordinate
+    @param    y1     Lower right y-coordinate
+    @param    r      Corner radius, limited to half of the smaller side
+    @param    color  Black(true)/white(false)
+    @param    fill   If true also fill the rectangle with the specified color
+*/
+void PCD8544_draw_round_rect(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, uint8_t r, bool color, bool fill)
+{
+    /* Just in case mistakes were made */
+    if(x0 > x1) SWAP_VAR(x0, x1);
+    if(y0 > y1) SWAP_VAR(y0, y1);
+
+    /* Sanity check */
+    if(!_bbox_visible(x0, x1, y0, y1)) return;
+
+    /* The corners must fit in the rectangle */
+    uint8_t max_r = ((x1 - x0) < (y1 - y0) ? (x1 - x0) : (y1 - y0)) / 2;
+    if(r > max_r) r = max_r;
+
+    if(!r)
+    {
+        PCD8544_draw_rectangle(x0, x1, y0, y1, color, fill);
+        return;
+    }
+
+    /* Corner centers */
+    uint8_t xl = x0 + r, xr = x1 - r;
+    uint8_t yt = y0 + r, yb = y1 - r;
+
+    if(fill)
+    {
+        /* Straight part, then the columns of the corners */
+        int16_t cx0 = xl, cx1 = xr, cy0 = y0, cy1 = y1;
+        if(_clip_rect(&cx0, &cx1, &cy0, &cy1)) _fill_block(cx0, cx1, cy0, cy1, color, _screen_h->pattern);
+
+        _fill_circle_spans(xl, xr, yt, yb, r, color);
+        return;
+    }
+
+    /* Straight edges, then the corners - Each pixel is drawn once (for XOR) */
+    PCD8544_draw_hline(xl, y0, xr - xl + 1, color);
+    PCD8544_draw_hline(xl, y1, xr - xl + 1, color);
+    PCD8544_draw_vline(x0, yt, yb - yt + 1, color);
+    PCD8544_draw_vline(x1, yt, yb - yt + 1, color);
+    _draw_circle_arcs(xl, xr, yt, yb, r, color);
+}
+
+/*!
+    @brief    Draws a filled polygon with N vertices - Uses a sorted edge table and an active edge list.
+    Pixels are sampled at their centers, so the right and bottom borders of the polygon are excluded.
+    This way polygons that share an edge never draw it twice.
+    No memory is allocated, the caller provides the workspace for the edge table.
+    @param    x      Array with the x-coordinates of the vertices
+    @param    y      Array with the y-coordinates of the vertices
+    @param    num    Number of vertices (at least 3)
+    @param    rule   Fill rule, PCD8544_FILL_EVENODD or PCD8544_FILL_NONZERO
+    @param    edges  Workspace for the edge table, must hold {num} entries
     @param    color  Black(true)/white(false)
 */
-void PCD8544_draw_triangle(uint8_t x0, uint8_t x1, uint8_t x2, uint8_t y0, uint8_t y1, uint8_t y2, bool color)
+void PCD8544_draw_fill_polygon(const uint8_t *x, const uint8_t *y, uint8_t num, uint8_t rule, pcd_8544_edge_t *edges, bool color)
+{
+    /* Sanity check */
+    if(!x || !y || !edges || num < 3) return;
+
+    const uint8_t end = 0xff;
+    uint8_t edge_num = 0, y_min = 0xff, y_max = 0;
+
+    /* Build the edge table - Horizontal edges never cross a scanline center, so they are dropped */
+    for(uint8_t i = 0; i < num; i++)
+    {
+        uint8_t j = (i + 1 == num) ? 0 : i + 1;
+        if(y[i] == y[j]) continue;
+
+        pcd_8544_edge_t *e = &edges[edge_num++];
+        uint8_t x_top = x[i], x_bot = x[j];
+
+        e->dir = 1;
+        e->y_top = y[i];
+        e->y_bot = y[j];
+
+        if(e->y_top > e->y_bot)
+        {
+            SWAP_VAR(e->y_top, e->y_bot);
+            SWAP_VAR(x_top, x_bot);
+            e->dir = -1;
+        }
+
+        /* Crossing of the first scanline center (y_top + 0.5) */
+        e->dx = ((int32_t)x_bot - x_top) * 65536 / (e->y_bot - e->y_top);
+        e->x = (int32_t)x_top * 65536 + e->dx / 2;
+
+        if(e->y_top < y_min) y_min = e->y_top;
+        if(e->y_bot > y_max) y_max = e->y_bot;
+    }
+
+    if(!edge_num) return;
+
+    /* Sort the edge table by the first scanline (insertion sort, tables are small) */
+    for(uint8_t i = 1; i < edge_num; i++)
+    {
+        pcd_8544_edge_t key = edges[i];
+        uint8_t j = i;
+
+        for(; j && edges[j - 1].y_top > key.y_top; j--) edges[j] = edges[j - 1];
+        edges[j] = key;
+    }
+
+    /* Scanlines below the clip rectangle are not needed */
+    if(!_bbox_visible(_screen_h->clip.x0, _screen_h->clip.x1, y_min, y_max - 1)) return;
+    if(y_max > _screen_h->clip.y1 + 1) y_max = _screen_h->clip.y1 + 1;
+
+    uint8_t active = end, next_edge = 0;
+
+    for(uint8_t scan = y_min; scan < y_max; scan++)
+    {
+        /* Insert the new edges in the active list */
+        for(; next_edge < edge_num && edges[next_edge].y_top == scan; next_edge++)
+        {
+            edges[next_edge].next = active;
+            active = next_edge;
+        }
+
+        /* Remove finished edges and sort the rest by x (the list is almost sorted already) */
+        uint8_t sorted = end;
+        while(active != end)
+        {
+            uint8_t cur = active;
+            active = edges[cur].next;
+
+            if(edges[cur].y_bot <= scan) continue;
+
+            uint8_t *link = &sorted;
+            while(*link != end && edges[*link].x < edges[cur].x) link = &edges[*link].next;
+
+            edges[cur].next = *link;
+            *link = cur;
+        }
+        active = sorted;
+
+        /* Walk the crossings and emit the spans according to the rule */
+        int8_t winding = 0;
+        int16_t span_start = 0;
+
+        for(uint8_t cur = active; cur != end; cur = edges[cur].next)
+        {
+            /* First pixel with its center right of the crossing */
+            int16_t px = (edges[cur].x + 0x7fff) >> 16;
+            int8_t old = winding;
+
+            winding = (rule == PCD8544_FILL_NONZERO) ? (winding + edges[cur].dir) : !winding;
+
+            if(!old && winding)
+            {
+                span_start = px;
+            }
+            else if(old && !winding && px > span_start)
+            {
+                _fill_hspan(span_start, px - 1, scan, color);
+            }
+
+            edges[cur].x += edges[cur].dx;
+        }
+    }
+}
+
+/*!
+    @brief    Finds the vertical run of pixels with a given color that contains (x, y).
+    Internal routine, it tests up to 8 pixels (a whole bank) per step.
+    @param    x       x-coordinate
+    @param    y       y-coordinate (must have the run's color)
+    @param    color   The color of the run
+    @param    top     Returns the uppermost y-coordinate of the run
+    @param    bot     Returns the lowermost y-coordinate of the run
+*/
+static void _column_run(uint8_t x, uint8_t y, bool color, uint8_t *top, uint8_t *bot)
+{
+    uint8_t flip = color ? 0 : 0xff;
+    uint8_t bank = y >> 3, shift = y & 0x07;
+
+    /* Downwards - Count the ones from the bit position to the MSB */
+    uint8_t bits = (TARGET_BUFFER[bank * TARGET_STRIDE + x] ^ flip) >> shift;
+    uint8_t cur = y;
+
+    while(bits == (0xff >> shift))
+    {
+        cur += 8 - shift;
+        shift = 0;
+        if(++bank >= TARGET_BANKS) break;
+        bits = TARGET_BUFFER[bank * TARGET_STRIDE + x] ^ flip;
+    }
+
+    if(bank < TARGET_BANKS) cur += __builtin_ctz(~bits);
+    *bot = cur - 1;
+
+    /* Upwards - Count the ones from the bit position to the LSB */
+    bank = y >> 3;
+    shift = 7 - (y & 0x07);
+    bits = (uint8_t)((TARGET_BUFFER[bank * TARGET_STRIDE + x] ^ flip) << shift);
+    cur = y;
+
+    while(bits == (uint8_t)(0xff << shift))
+    {
+        cur -= 8 - shift;
+        shift = 0;
+        if(!bank--) break;
+        bits = TARGET_BUFFER[bank * TARGET_STRIDE + x] ^ flip;
+    }
+
+    if(bank != 0xff) cur -= __builtin_clz((uint32_t)(uint8_t)~bits) - 24;
+    *top = cur + 1;
+
+    /* The clip rectangle acts as a boundary */
+    if(*top < _screen_h->clip.y0) *top = _screen_h->clip.y0;
+    if(*bot > _screen_h->clip.y1) *bot = _screen_h->clip.y1;
+}
+
+/*!
+    @brief    Finds the first pixel with a given color inside a column range.
+    Internal routine, it tests up to 8 pixels (a whole bank) per step.
+    @param    x       x-coordinate
+    @param    y0      Starting y-coordinate
+    @param    y1      Ending y-coordinate (inclusive)
+    @param    color   The color to look for
+    @return           The y-coordinate found, or 0xff if there is none
+*/
+static uint8_t _column_find(uint8_t x, uint8_t y0, uint8_t y1, bool color)
+{
+    uint8_t flip = color ? 0 : 0xff;
+
+    /* Wider than the coordinates, the next bank of the last one is past 255 */
+    for(uint16_t y = y0; y <= y1; y = (y | 0x07) + 1)
+    {
+        uint8_t bits = (TARGET_BUFFER[(y >> 3) * TARGET_STRIDE + x] ^ flip) >> (y & 0x07);
+
+        if(bits)
+        {
+            y += __builtin_ctz(bits);
+            return (y <= y1) ? y : 0xff;
+        }
+    }
+
+    return 0xff;
+}
+
+/*!
+    @brief    Tells whether a pixel belongs to the area being flood filled. Internal routine.
+    @param    st      The flood fill state
+    @param    x       x-coordinate
+    @param    y       y-coordinate
+    @return           True if the pixel is inside the clip rectangle and has the area's color
+*/
+static bool _fill_inside(const _fill_state_t *st, int16_t x, int16_t y)
 {
-    PCD8544_draw_line(x0, x1, y0, y1, color);
-    PCD8544_draw_line(x1, x2, y1, y2, color);
-    PCD8544_draw_line(x0, x2, y0, y2, color);
+    return _in_clip(x, y) && _get_single_pixel(x, y) == st->target;
 }
 
 /*!
-    @brief    Draws a filled triangle. Also taken by the Adafruit GFX library.
-    @param    x0     First x-coordinate
-    @param    x1     Second x-coordinate
-    @param    x2     Third x-coordinate
-    @param    y0     First y-coordinate
-    @param    y1     Second y-coordinate
-    @param    y2     Third y-coordinate
-    @param    color  Triangle color, Black(true)/white(false)
+    @brief    Moves one pixel along the border of the area, keeping the outside on the right hand. Internal routine.
+    Every side found blocked on the way is an edge of the same boundary, which is checked against a few walls.
+    @param    st      The flood fill state
+    @param    w       The walker, a pixel of the area and its heading
+    @param    walls   The first edge of each wall, a pixel of the area and its side that is outside
+    @param    num     Number of walls
+    @return           Mask of the walls whose first edge was passed
 */
-void PCD8544_draw_fill_triangle(uint8_t x0, uint8_t x1, uint8_t x2, uint8_t y0, uint8_t y1, uint8_t y2, bool color)
+static uint8_t _fill_trace(const _fill_state_t *st, _walk_t *w, const _walk_t *walls, uint8_t num)
 {
-    uint8_t a, b, y, last;
+    uint8_t found = 0;
 
-    /* Sort coordinates by Y order (y2 >= y1 >= y0) */
-    if (y0 > y1)
+    /* Right first, then ahead, left and back */
+    for(uint8_t i = 0, d = (w->dir + 1) & 0x03; i < 4; i++, d = (d + 3) & 0x03)
     {
-        SWAP_VAR(y0, y1);
-        SWAP_VAR(x0, x1);
+        if(_fill_inside(st, w->x + _walk_dx[d], w->y + _walk_dy[d]))
+        {
+            *w = (_walk_t){ .x = w->x + _walk_dx[d], .y = w->y + _walk_dy[d], .dir = d };
+            break;
+        }
+
+        for(uint8_t j = 0; j < num; j++)
+        {
+            if(w->x == walls[j].x && w->y == walls[j].y && d == walls[j].dir) found |= 1 << j;
+        }
     }
 
-    if (y1 > y2)
+    return found;
+}
+
+/*!
+    @brief    Tells whether a pixel can be filled without splitting the rest of the area. Internal routine.
+    The neighbours of the pixel that belong to the area form groups around it, separated by walls of
+    outside pixels. With more than one group, they stay connected without the pixel only if every wall
+    is on a boundary of its own, i.e. the pixel is on a loop around each of them. The boundaries of all
+    walls are walked together, so the shortest one decides.
+    @param    st      The flood fill state
+    @param    x       x-coordinate (must belong to the area)
+    @param    y       y-coordinate (must belong to the area)
+    @param    loops   Walk the boundaries, otherwise only a single group of neighbours is accepted
+    @return           True if the pixel can be filled
+*/
+static bool _fill_removable(const _fill_state_t *st, int16_t x, int16_t y, bool loops)
+{
+    _walk_t walls[4], w[4];
+    uint8_t num = 0;
+    bool in[8];
+
+    for(uint8_t i = 0; i < 8; i++) in[i] = _fill_inside(st, x + _ring_dx[i], y + _ring_dy[i]);
+
+    /* A corner only joins a group through one of its sides */
+    for(uint8_t i = 1; i < 8; i += 2) in[i] = in[i] && (in[i - 1] || in[(i + 1) & 0x07]);
+
+    /* Every wall starts with an edge of the last pixel of the group before it */
+    for(uint8_t i = 0; i < 8; i++)
     {
-        SWAP_VAR(y2, y1);
-        SWAP_VAR(x2, x1);
+        uint8_t prev = (i + 7) & 0x07;
+        if(!in[i] && in[prev]) walls[num++] = (_walk_t){ .x = x + _ring_dx[prev], .y = y + _ring_dy[prev], .dir = i >> 1 };
     }
 
-    if (y0 > y1)
+    if(num < 2) return true;
+    if(!loops) return false;
+
+    /* The first step of each walk passes its own wall */
+    for(uint8_t j = 0; j < num; j++)
     {
-        SWAP_VAR(y0, y1);
-        SWAP_VAR(x0, x1);
+        w[j] = (_walk_t){ .x = walls[j].x, .y = walls[j].y, .dir = (walls[j].dir + 3) & 0x03 };
+        if(_fill_trace(st, &w[j], walls, num) & ~(1 << j)) return false;
     }
 
-    /* Handle awkward all-on-same-line case as its own thing */
-    if(y0 == y2)
+    /* Walls whose walk comes back alone are on a boundary of their own */
+    uint8_t open = (1 << num) - 1;
+    uint32_t steps = 4UL * TARGET_WIDTH * TARGET_HEIGHT;
+
+    while(steps-- && (open & (open - 1)))
     {
-        a = b = x0;
-        if (x1 < a)       a = x1;
-        else if (x1 > b)  b = x1;
+        for(uint8_t j = 0; j < num; j++)
+        {
+            if(!(open & (1 << j))) continue;
 
-        if (x2 < a)       a = x2;
-        else if (x2 > b)  b = x2;
+            uint8_t found = _fill_trace(st, &w[j], walls, num);
+            if(found & ~(1 << j)) return false;
+            if(found) open &= ~(1 << j);
+        }
+    }
+
+    return !(open & (open - 1));
+}
+
+/*!
+    @brief    Fills the whole area that contains a pixel without any stack. Internal routine.
+    A walker goes along the border of the area and fills every pixel that does not split what is left
+    of it, so the rest stays connected until the last pixel. Pixels with a single group of neighbours
+    are taken first, the loop checks only run once a whole lap found none. It tests pixel by pixel,
+    so it is much slower than the span stack and only used when the stack is full.
+    @param    st      The flood fill state
+    @param    x       x-coordinate (must belong to the area)
+    @param    y       y-coordinate (must belong to the area)
+*/
+static void _fill_walk(const _fill_state_t *st, int16_t x, int16_t y)
+{
+    const pcd_8544_rect_t *clip = &_screen_h->clip;
+    uint32_t idle = 0, limit = 4UL * (clip->x1 - clip->x0 + 1) * (clip->y1 - clip->y0 + 1);
+    _walk_t w = { .x = x, .y = y, .dir = 0 }, mark = w;
+    bool loops = false, marked = false;
+
+    for(;;)
+    {
+        if(!_fill_removable(st, w.x, w.y, loops))
+        {
+            _fill_trace(st, &w, NULL, 0);
+
+            /* The lap starts after a step, the pixel it came from may not be on the border walked */
+            if(!marked)
+            {
+                mark = w;
+                marked = true;
+            }
+            else if((w.x == mark.x && w.y == mark.y && w.dir == mark.dir) || ++idle > limit)
+            {
+                /* A lap with the loop checks always fills something, but it must not hang */
+                if(loops) return;
+                loops = true;
+                idle = 0;
+            }
+            continue;
+        }
+
+        _set_single_pixel(w.x, w.y, !st->target);
+
+        /* Carry on from any neighbour, the area left is still connected */
+        uint8_t d = 0;
+        while(d < 4 && !_fill_inside(st, w.x + _walk_dx[d], w.y + _walk_dy[d])) d++;
+        if(d == 4) return;
+
+        w = (_walk_t){ .x = w.x + _walk_dx[d], .y = w.y + _walk_dy[d], .dir = d };
+        loops = marked = false;
+        idle = 0;
+    }
+}
+
+/*!
+    @brief    Pushes a span to the flood fill stack. Internal routine.
+    When the stack is full, the runs that touch the span are filled right away with _fill_walk(),
+    together with everything connected to them, so nothing is lost.
+    @param    st      The flood fill state
+    @param    x       Column of the span
+    @param    y0      Uppermost y-coordinate of the span
+    @param    y1      Lowermost y-coordinate of the span
+    @param    dir     Direction of the search (-1 left, +1 right, 0 seed)
+*/
+static void _span_push(_fill_state_t *st, int16_t x, uint8_t y0, uint8_t y1, int8_t dir)
+{
+    if(x < _screen_h->clip.x0 || x > _screen_h->clip.x1) return;
 
-        PCD8544_draw_hline(a, y0, b - a + 1, color);
+    if(st->sp < st->size)
+    {
+        st->stack[st->sp++] = (pcd_8544_span_t){ .x = x, .y0 = y0, .y1 = y1, .dir = dir };
         return;
     }
 
-    uint8_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0,
-            dx12 = x2 - x1, dy12 = y2 - y1;
-    uint16_t sa = 0, sb = 0;
+    st->overflow = true;
 
-    /* For upper part of triangle, find scanline crossings for segments 0-1 and 0-2.
-     * If y1=y2 (flat-bottomed triangle), the scanline y1
-     * is included here (and second loop will be skipped, avoiding a /0
-     * error there), otherwise scanline y1 is skipped here and handled
-     * in the second loop...which also avoids a /0 error here if y0=y1
-     * (flat-topped triangle).
-     */
+    for(uint16_t cur = y0; (cur = _column_find(x, cur, y1, st->target)) != 0xff; cur++)
+    {
+        _fill_walk(st, x, cur);
+    }
+}
 
-    /* Include y1 scanline(?) or skip it(:) */
-    last = (y1 == y2) ? y1 : (y1 - 1);
+/*!
+    @brief    Fills the runs of every span in the stack, until it is empty. Internal routine.
+    @param    st      The flood fill state
+*/
+static void _span_drain(_fill_state_t *st)
+{
+    while(st->sp)
+    {
+        pcd_8544_span_t span = st->stack[--st->sp];
+        uint16_t cur = span.y0;
 
-    for (y = y0; y <= last; y++)
+        /* Fill every run of the column that touches the span */
+        while((cur = _column_find(span.x, cur, span.y1, st->target)) != 0xff)
+        {
+            uint8_t top, bot;
+            _column_run(span.x, cur, st->target, &top, &bot);
+            PCD8544_draw_vline(span.x, top, bot - top + 1, !st->target);
+
+            if(!span.dir)
+            {
+                _span_push(st, span.x + 1, top, bot, 1);
+                _span_push(st, span.x - 1, top, bot, -1);
+            }
+            else
+            {
+                /* The column we came from only needs the parts that stick out of the parent span */
+                _span_push(st, span.x + span.dir, top, bot, span.dir);
+                if(top < span.y0) _span_push(st, span.x - span.dir, top, span.y0 - 1, -span.dir);
+                if(bot > span.y1) _span_push(st, span.x - span.dir, span.y1 + 1, bot, -span.dir);
+            }
+
+            cur = bot + 1;
+        }
+    }
+}
+
+/*!
+    @brief    Flood fills the area that contains a seed pixel - Uses a span stack over columns.
+    The area is the 4-connected region with the seed's color, which is recolored. The clip rectangle
+    bounds the area as well. Since a pixel
+    is either black or white, this is also a boundary fill for outlines drawn with {color}.
+    Spans run vertically, so up to 8 pixels (a whole bank) are tested and filled per byte operation. The fill is always
+    solid, the stipple pattern and raster operation are ignored.
+
+    The stack is provided by the caller and bounds the memory used, e.g. a convex area takes a few entries.
+    When it is full, the part of the area behind a span that does not fit is filled by walking along its
+    border instead, which needs no memory but tests pixel by pixel. The fill always completes.
+    @param    x         Seed x-coordinate
+    @param    y         Seed y-coordinate
+    @param    color     Black(true)/white(false)
+    @param    stack     Span stack workspace
+    @param    stack_sz  Number of entries in the stack
+    @return             Success(True) or Failure(False) on invalid arguments or if the stack was too small and the walk was used.
+*/
+bool PCD8544_flood_fill(uint8_t x, uint8_t y, bool color, pcd_8544_span_t *stack, uint16_t stack_sz)
+{
+    /* Sanity check */
+    if(!_in_clip(x, y) || !stack || !stack_sz) return false;
+
+    _fill_state_t st = { .stack = stack, .sp = 0, .size = stack_sz, .target = !color, .overflow = false };
+
+    /* Nothing to do, the area already has the color */
+    if(_get_single_pixel(x, y) != st.target) return true;
+
+    /* The fill relies on the filled runs changing color, so it always overwrites */
+    uint8_t rop = _screen_h->rop;
+    _screen_h->rop = PCD8544_ROP_COPY;
+
+    _span_push(&st, x, y, y, 0);
+    _span_drain(&st);
+
+    _screen_h->rop = rop;
+
+    return !st.overflow;
+}
+
+/**********************************************************/
+/************************ BITMAPS *************************/
+/**********************************************************/
+
+/*!
+    @brief    Draws a bitmap on the screen, at any position.
+    Bitmaps that do not start at a bank boundary are shifted across two banks, so the cost
+    is close to the aligned PCD8544_draw_bitmap_opt8().
+    @param    bitmap    The bitmap array
+    @param    x0        Leftmost x-coordinate
+    @param    y0        Leftmost y-coordinate
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+*/
+void PCD8544_draw_bitmap(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y)
+{
+    _blit(bitmap, NULL, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a bitmap on the screen.
+    Optimized version that draws bitmaps with height a multiple of 8
+    and that start from a multiple of 8 y-coordinate.
+    Basically we draw from the start of a bank continuously.
+
+    @param    bitmap    The bitmap array
+    @param    x0        Leftmost x-coordinate
+    @param    y0        Leftmost y-coordinate
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+*/
+void PCD8544_draw_bitmap_opt8(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y)
+{
+    /* Illegal format of the bitmap or initial position or height */
+    if(!bitmap || (y0 & 0x07) || (len_y & 0x07)) return;
+
+    /* Aligned banks are copied as they are */
+    _blit(bitmap, NULL, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a sprite with a mask, at any position. Only the pixels set in the mask are drawn,
+    dst = (dst & ~mask) | (src & mask), so sprites can move over a background without saving it.
+    @param    bitmap    The sprite bitmap array
+    @param    mask      The mask array, same layout and size as the bitmap. NULL draws the whole sprite.
+    @param    x0        Leftmost x-coordinate
+    @param    y0        Uppermost y-coordinate
+    @param    len_x     The width of the sprite
+    @param    len_y     The height of the sprite
+*/
+void PCD8544_draw_sprite(const uint8_t *bitmap, const uint8_t *mask, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y)
+{
+    _blit(bitmap, mask, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a sprite with a transparent color, at any position. The pixels of the
+    transparent color are left untouched, the rest of the sprite is drawn.
+    @param    bitmap       The sprite bitmap array
+    @param    x0           Leftmost x-coordinate
+    @param    y0           Uppermost y-coordinate
+    @param    len_x        The width of the sprite
+    @param    len_y        The height of the sprite
+    @param    transparent  The transparent color, black(true)/white(false)
+*/
+void PCD8544_draw_sprite_key(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y, bool transparent)
+{
+    _blit(bitmap, NULL, transparent ? _BLIT_KEY_BLACK : _BLIT_KEY_WHITE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a bitmap on the screen, with a signed origin. The bitmap can be partially
+    off-screen on any side (e.g. sliding in from the left or the top), the rows and columns
+    outside the screen or clip rectangle are skipped.
+    @param    bitmap    The bitmap array
+    @param    x0        Leftmost x-coordinate, can be negative
+    @param    y0        Uppermost y-coordinate, can be negative
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+*/
+void PCD8544_draw_bitmap_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y)
+{
+    _blit(bitmap, NULL, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a bitmap on the screen, with a signed origin. Same as PCD8544_draw_bitmap_opt8(),
+    y0 (negative too) and the height must be multiples of 8.
+    @param    bitmap    The bitmap array
+    @param    x0        Leftmost x-coordinate, can be negative
+    @param    y0        Uppermost y-coordinate, can be negative
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+*/
+void PCD8544_draw_bitmap_opt8_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y)
+{
+    /* Illegal format of the bitmap or initial position or height */
+    if(!bitmap || (y0 & 0x07) || (len_y & 0x07)) return;
+
+    _blit(bitmap, NULL, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a sprite with a mask, with a signed origin. See PCD8544_draw_sprite().
+    @param    bitmap    The sprite bitmap array
+    @param    mask      The mask array, same layout and size as the bitmap. NULL draws the whole sprite.
+    @param    x0        Leftmost x-coordinate, can be negative
+    @param    y0        Uppermost y-coordinate, can be negative
+    @param    len_x     The width of the sprite
+    @param    len_y     The height of the sprite
+*/
+void PCD8544_draw_sprite_s(const uint8_t *bitmap, const uint8_t *mask, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y)
+{
+    _blit(bitmap, mask, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a sprite with a transparent color, with a signed origin. See PCD8544_draw_sprite_key().
+    @param    bitmap       The sprite bitmap array
+    @param    x0           Leftmost x-coordinate, can be negative
+    @param    y0           Uppermost y-coordinate, can be negative
+    @param    len_x        The width of the sprite
+    @param    len_y        The height of the sprite
+    @param    transparent  The transparent color, black(true)/white(false)
+*/
+void PCD8544_draw_sprite_key_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, bool transparent)
+{
+    _blit(bitmap, NULL, transparent ? _BLIT_KEY_BLACK : _BLIT_KEY_WHITE, x0, y0, len_x, len_y, len_x);
+}
+
+/*!
+    @brief    Draws a bitmap scaled up by an integer factor (nearest neighbour), e.g. large numerals
+    and icons out of small assets. Each bank byte is expanded into scale banks with a lookup and
+    repeated over scale columns, up to 32 columns at a time, then blitted like a native bitmap.
+    @param    bitmap    The bitmap array
+    @param    x0        Leftmost x-coordinate, can be negative
+    @param    y0        Uppermost y-coordinate, can be negative
+    @param    len_x     The width of the bitmap (before scaling)
+    @param    len_y     The height of the bitmap (before scaling)
+    @param    scale     The factor, 1 to 4
+*/
+void PCD8544_draw_bitmap_scaled(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, uint8_t scale)
+{
+    /* Illegal format of the bitmap */
+    if(!bitmap || !len_x || !len_y || !scale || scale > 4) return;
+
+    if(scale == 1)
     {
-        a = x0 + sa / dy01;
-        b = x0 + sb / dy02;
-        sa += dx01;
-        sb += dx02;
-        /* longhand:
-        a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-        b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-        */
-        if (a > b) SWAP_VAR(a, b);
-        PCD8544_draw_hline(a, y, b - a + 1, color);
+        _blit(bitmap, NULL, _BLIT_OPAQUE, x0, y0, len_x, len_y, len_x);
+        return;
     }
 
-    /* For lower part of triangle, find scanline crossings for segments
-     * 0-2 and 1-2.  This loop is skipped if y1=y2.
-     */
-    sa = (uint16_t)dx12 * (y - y1);
-    sb = (uint16_t)dx02 * (y - y0);
-    for (; y <= y2; y++)
+    uint8_t strip[4][32];
+    uint8_t chunk = sizeof(strip[0]) / scale;
+
+    for(uint8_t bank = 0; bank < ((len_y + 7) >> 3); bank++)
     {
-        a = x1 + sa / dy12;
-        b = x0 + sb / dy02;
-        sa += dx12;
-        sb += dx02;
-        /* longhand:
-        a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-        b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-        */
-        if (a > b) SWAP_VAR(a, b);
-        PCD8544_draw_hline(a, y, b - a + 1, color);
+        /* Output rows of this bank */
+        uint16_t oy = (bank << 3) * scale;
+        uint8_t rows = (len_y * scale - oy < 8 * scale) ? len_y * scale - oy : 8 * scale;
+
+        for(uint16_t x = 0; x < len_x; x += chunk)
+        {
+            uint8_t cols = (len_x - x < chunk) ? len_x - x : chunk;
+
+            /* Nothing to expand outside the clip rectangle */
+            int16_t cx0 = x0 + x * scale, cx1 = cx0 + cols * scale - 1, cy0 = y0 + oy, cy1 = cy0 + rows - 1;
+            if(!_clip_rect(&cx0, &cx1, &cy0, &cy1)) continue;
+
+            const uint8_t *src = bitmap + bank * len_x + x;
+
+            for(uint8_t i = 0; i < cols; i++)
+            {
+                uint32_t column;
+                if(scale == 2) column = _expand_2x[src[i]];
+                else if(scale == 3) column = _expand_3x[src[i] & 0x0f] | ((uint32_t)_expand_3x[src[i] >> 4] << 12);
+                else column = _expand_2x[_expand_2x[src[i]] & 0xff] | ((uint32_t)_expand_2x[_expand_2x[src[i]] >> 8] << 16);
+
+                for(uint8_t k = 0; k < scale; k++, column >>= 8) memset(&strip[k][i * scale], (uint8_t)column, scale);
+            }
+
+            _blit(strip[0], NULL, _BLIT_OPAQUE, x0 + x * scale, y0 + oy, cols * scale, rows, sizeof(strip[0]));
+        }
+    }
+}
+
+/*!
+    @brief    Draws a bitmap resized to any size (nearest neighbour). The source pixel of every output
+    pixel is found by stepping in 16.16 fixed point, sampling at the pixel centers.
+    @param    bitmap    The bitmap array
+    @param    x0        Leftmost x-coordinate, can be negative
+    @param    y0        Uppermost y-coordinate, can be negative
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+    @param    out_x     The width of the drawn bitmap
+    @param    out_y     The height of the drawn bitmap
+*/
+void PCD8544_draw_bitmap_resized(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, uint8_t out_x, uint8_t out_y)
+{
+    /* Illegal format of the bitmap */
+    if(!bitmap || !len_x || !len_y || !out_x || !out_y) return;
+
+    uint32_t step_x = ((uint32_t)len_x << 16) / out_x, step_y = ((uint32_t)len_y << 16) / out_y;
+    const uint8_t *row_src[8];
+    uint8_t row_bit[8], strip[32], chunk = sizeof(strip);
+
+    for(uint16_t oy = 0; oy < out_y; oy += 8)
+    {
+        uint8_t rows = (out_y - oy < 8) ? out_y - oy : 8;
+
+        /* Source bank and bit of each output row */
+        for(uint8_t j = 0; j < rows; j++)
+        {
+            uint8_t sy = ((oy + j) * step_y + (step_y >> 1)) >> 16;
+            row_src[j] = bitmap + (sy >> 3) * len_x;
+            row_bit[j] = sy & 0x07;
+        }
+
+        for(uint16_t ox = 0; ox < out_x; ox += chunk)
+        {
+            uint8_t cols = (out_x - ox < chunk) ? out_x - ox : chunk;
+
+            /* Nothing to sample outside the clip rectangle */
+            int16_t cx0 = x0 + ox, cx1 = cx0 + cols - 1, cy0 = y0 + oy, cy1 = cy0 + rows - 1;
+            if(!_clip_rect(&cx0, &cx1, &cy0, &cy1)) continue;
+
+            uint32_t fx = ox * step_x + (step_x >> 1);
+
+            for(uint8_t i = 0; i < cols; i++, fx += step_x)
+            {
+                uint8_t sx = fx >> 16, byte = 0;
+                for(uint8_t j = 0; j < rows; j++) byte |= ((row_src[j][sx] >> row_bit[j]) & 0x01) << j;
+                strip[i] = byte;
+            }
+
+            _blit(strip, NULL, _BLIT_OPAQUE, x0 + ox, y0 + oy, cols, rows, cols);
+        }
     }
 }
 
 /*!
-    @brief    Draws a circle - Uses the Midpoint circle algorithm.
-    @param    x0   Center x-coordinate
-    @param    y0   Center y-coordinate
-    @param    r    Circle radius
-    @param    color - black(true)/white(false)
+    @brief    Draws a run-length encoded bitmap (see PCD8544_RLE_RUN), decoded straight into the buffer.
+    Every decoded byte lands in one bank, or two when y0 is not a multiple of 8, so nothing is
+    decoded into a temporary buffer. Runs are drawn with the word-wide span kernel, so the long
+    runs of white and black of most images cost far less than copying them.
+    Decoding stops at the last bank inside the clip rectangle.
+    @param    data      The encoded bitmap
+    @param    x0        Leftmost x-coordinate, can be negative
+    @param    y0        Uppermost y-coordinate, can be negative
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
 */
-void PCD8544_draw_circle(uint8_t x, uint8_t y, uint8_t r, bool color)
+void PCD8544_draw_bitmap_rle(const uint8_t *data, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y)
 {
-    int8_t a = 0;
-    int8_t b = r;
-    int8_t p = 1 - r;
+    /* Clip once - Illegal format of the bitmap or nothing to draw */
+    int16_t cx0 = x0, cx1 = x0 + len_x - 1, cy0 = y0, cy1 = y0 + len_y - 1;
+    if(!data || !len_x || !len_y || !_clip_rect(&cx0, &cx1, &cy0, &cy1)) return;
 
-    do
+    uint8_t banks = (len_y + 7) >> 3;
+    uint8_t last_valid = (len_y & 0x07) ? 0xff >> (8 - (len_y & 0x07)) : 0xff;
+    _rle_dst_t dst = { .ix0 = cx0 - x0, .ix1 = cx1 - x0, .shift = y0 & 0x07, .rop = _screen_h->rop };
+
+    uint8_t bank = 0, i = 0;
+    _rle_bank(&dst, x0, y0, cy0, cy1, bank, (banks == 1) ? last_valid : 0xff);
+
+    while(bank < banks && (y0 >> 3) + bank <= (cy1 >> 3))
     {
-        PCD8544_set_pixel(x+a, y+b, color);
-        PCD8544_set_pixel(x+b, y+a, color);
-        PCD8544_set_pixel(x+a, y-b, color);
-        PCD8544_set_pixel(x+b, y-a, color);
-        PCD8544_set_pixel(x-a, y+b, color);
-        PCD8544_set_pixel(x-b, y+a, color);
-        PCD8544_set_pixel(x-a, y-b, color);
-        PCD8544_set_pixel(x-b, y-a, color);
+        /* Packet header - A run of the next byte or a number of literal bytes */
+        uint8_t header = *data++;
+        bool run = header & PCD8544_RLE_RUN;
+        uint8_t len = run ? (header & ~PCD8544_RLE_RUN) + 2 : header + 1;
+        uint8_t byte = run ? *data++ : 0;
 
-        if(p < 0)
-        {
-            p += (3 + 2*a);
-            a++;
-        }
-        else
+        while(len && bank < banks)
         {
-            p += (5 + 2*(a-b));
-            a++;
-            b--;
+            /* Packets can continue into the next bank */
+            uint8_t piece = (len < len_x - i) ? len : len_x - i;
+
+            if(run) _rle_run(&dst, byte, i, piece);
+            else for(uint8_t j = 0; j < piece; j++) _rle_byte(&dst, *data++, i + j);
+
+            i += piece;
+            len -= piece;
+
+            if(i == len_x)
+            {
+                i = 0;
+                if(++bank < banks) _rle_bank(&dst, x0, y0, cy0, cy1, bank, (bank == banks - 1) ? last_valid : 0xff);
+            }
         }
-    }while(a <= b);
+    }
 }
 
 /*!
-    @brief    Draws a filled circle - Uses the Midpoint circle algorithm.
-    @param    x0   Center x-coordinate
-    @param    y0   Center y-coordinate
-    @param    r    Circle radius
-    @param    color - black(true)/white(false)
+    @brief    Draws a row-major bitmap, as exported by most tools and used by other GFX libraries
+    ((len_x + 7) / 8 bytes per row, set bits are black). Each 8x8 block is converted with a transpose
+    into bank bytes, up to 32 columns at a time, and blitted like a native bitmap, so nothing has
+    to be converted or copied beforehand.
+    @param    bitmap      The bitmap array
+    @param    x0          Leftmost x-coordinate, can be negative
+    @param    y0          Uppermost y-coordinate, can be negative
+    @param    len_x       The width of the bitmap
+    @param    len_y       The height of the bitmap
+    @param    lsb_first   The bit order of a row byte, LSB is the leftmost pixel(true, XBM) or MSB is(false, Adafruit)
 */
-void PCD8544_draw_fill_circle(uint8_t x0, uint8_t y0, uint8_t r, bool color)
+void PCD8544_draw_bitmap_rows(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, bool lsb_first)
 {
-    /* Write out the middle line - we use the pixel setters since lines might be out of bounds */
-    for(uint8_t i = 0; i < (2 * r + 1); i++) PCD8544_set_pixel(x0, y0 - r + i, color);
+    /* Illegal format of the bitmap */
+    if(!bitmap || !len_x || !len_y) return;
 
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
-    int16_t y = r;
-    int16_t px = x;
-    int16_t py = y;
+    uint8_t row_bytes = (len_x + 7) >> 3;
+    uint8_t strip[32], block[8], chunk = sizeof(strip);
 
-    while (x < y)
+    for(uint16_t y = 0; y < len_y; y += 8)
     {
-        if (f >= 0)
+        uint8_t rows = (len_y - y < 8) ? len_y - y : 8;
+
+        for(uint16_t x = 0; x < len_x; x += chunk)
         {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
+            uint8_t cols = (len_x - x < chunk) ? len_x - x : chunk;
 
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
+            /* Nothing to convert outside the clip rectangle */
+            int16_t cx0 = x0 + x, cx1 = cx0 + cols - 1, cy0 = y0 + y, cy1 = cy0 + rows - 1;
+            if(!_clip_rect(&cx0, &cx1, &cy0, &cy1)) continue;
 
-        // These checks avoid double-drawing certain lines, important
-        // for the SSD1306 library which has an INVERT drawing mode.
-        if (x < (y + 1))
-        {
-            for(uint i = 0; i < 2 * y; i++) /* Same as initial vline drawing */
+            for(uint8_t c = 0; c < cols; c += 8)
             {
-                PCD8544_set_pixel(x0 + x, y0 - y + i, color);
-                PCD8544_set_pixel(x0 - x, y0 - y + i, color);
-            }
-        }
+                const uint8_t *src = bitmap + y * row_bytes + ((x + c) >> 3);
+                for(uint8_t r = 0; r < 8; r++) block[r] = (r < rows) ? src[r * row_bytes] : 0;
 
-        if (y != py)
-        {
-            for(uint i = 0; i < 2 * px; i++) /* Same as initial vline drawing */
-            {
-                PCD8544_set_pixel(x0 + py, y0 - px + i, color);
-                PCD8544_set_pixel(x0 - py, y0 - px + i, color);
+                /* Row bytes become column bytes - MSB first rows come out in reverse order */
+                _transpose_block(block);
+                for(uint8_t k = 0; k < 8 && c + k < cols; k++) strip[c + k] = lsb_first ? block[k] : block[7 - k];
             }
 
-            py = y;
+            _blit(strip, NULL, _BLIT_OPAQUE, x0 + x, y0 + y, cols, rows, cols);
         }
-
-        px = x;
     }
+}
+
+/*!
+    @brief    Mirrors or rotates a bitmap into another one, e.g. to turn a sprite around once
+    instead of keeping every orientation in flash. See PCD8544_transform().
+    @param    bitmap    The bitmap array
+    @param    out       The output array - (len_y * ((len_x + 7) / 8)) bytes when transposing
+    @param    len_x     The width of the bitmap
+    @param    len_y     The height of the bitmap
+    @param    op        The transform (PCD8544_ROTATE_90, _180, _270, PCD8544_MIRROR_X, _MIRROR_Y or PCD8544_TRANSPOSE)
+*/
+void PCD8544_transform_bitmap(const uint8_t *bitmap, uint8_t *out, uint8_t len_x, uint8_t len_y, uint8_t op)
+{
+    /* Illegal format of the bitmap */
+    if(!bitmap || !out || bitmap == out || !len_x || !len_y) return;
 
+    _transform(bitmap, len_x, len_y, len_x, out, (op & PCD8544_TRANSPOSE) ? len_y : len_x, op);
 }
 
+/**********************************************************/
+/************************ SURFACES ************************/
+/**********************************************************/
+
 /*!
-    @brief    Draw a rounded rectangle.
-    @param    x0     Upper left x-coordinate
-    @param    x1     Lower right x-coordinate
-    @param    y0     Upper left y-coordinate
-    @param    y1     Lower right y-coordinate
-    @param    color  Black(true)/white(false)
-    @param    fill   If true also fill the rectangle with the specified color
+    @brief    Initializes an offscreen surface. The buffer has the display's layout, banks of
+    8 rows with one byte per column, and must be PCD8544_SURFACE_SZ(width, height) bytes.
+    @param    surface   The surface
+    @param    buffer    The pixel buffer
+    @param    width     The width in pixels
+    @param    height    The height in pixels
 */
-void PCD8544_draw_round_rect(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool color, bool fill)
+void PCD8544_surface_init(pcd_8544_surface_t *surface, uint8_t *buffer, uint8_t width, uint8_t height)
 {
-    /* Just in case mistakes were made */
-    if(x0 > x1) SWAP_VAR(x0, x1);
-    if(y0 > y1) SWAP_VAR(y0, y1);
+    surface->buffer = buffer;
+    surface->width = width;
+    surface->height = height;
+    surface->stride = width;
+}
+
+/*!
+    @brief    Redirects all drawing routines (shapes, bitmaps and text) to a surface, or back to the
+    display buffer. The clip is reset to the whole target and the pushed clip rectangles are dropped.
+    The refresh always sends the display buffer. Call with NULL after replacing the handle's buffer.
+    @param    surface   The surface, NULL for the display buffer
+    @return             Success(True) or Failure(False) if the surface is invalid.
+*/
+bool PCD8544_target(const pcd_8544_surface_t *surface)
+{
+    if(surface && (!surface->buffer || !surface->width || !surface->height || surface->stride < surface->width))
+        return false;
+
+    _set_target(surface);
+
+    return true;
+}
+
+/*!
+    @brief    Blits a region of a surface to the draw target, using the current raster operation
+    and clip rectangle. The source region can start at any row, it is shifted across the banks
+    like the bitmaps are. The surface must not be the draw target.
+    @param    src   The source surface
+    @param    sx0   Left-most x-coordinate of the source region
+    @param    sx1   Right-most x-coordinate of the source region
+    @param    sy0   Uppermost y-coordinate of the source region
+    @param    sy1   Lowermost y-coordinate of the source region
+    @param    x0    Leftmost x-coordinate in the target, can be out of bounds
+    @param    y0    Uppermost y-coordinate in the target, can be out of bounds
+*/
+void PCD8544_blit_surface(const pcd_8544_surface_t *src, uint8_t sx0, uint8_t sx1, uint8_t sy0, uint8_t sy1, int16_t x0, int16_t y0)
+{
+    /* Sanity check */
+    if(!src || !src->buffer) return;
+    if(sx0 > sx1) SWAP_VAR(sx0, sx1);
+    if(sy0 > sy1) SWAP_VAR(sy0, sy1);
+    if(sx0 >= src->width || sy0 >= src->height) return;
+    if(sx1 >= src->width) sx1 = src->width - 1;
+    if(sy1 >= src->height) sy1 = src->height - 1;
+
+    /* The source starts at its bank boundary, the rows above sy0 are clipped away */
+    pcd_8544_rect_t clip = _screen_h->clip;
+    int16_t cx0 = x0, cx1 = x0 + (sx1 - sx0), cy0 = y0, cy1 = y0 + (sy1 - sy0);
+    if(!_clip_rect(&cx0, &cx1, &cy0, &cy1)) return;
+
+    _screen_h->clip = (pcd_8544_rect_t){ .x0 = cx0, .x1 = cx1, .y0 = cy0, .y1 = cy1 };
+
+    _blit(src->buffer + (sy0 >> 3) * src->stride + sx0, NULL, _BLIT_OPAQUE, x0, y0 - (sy0 & 0x07),
+          sx1 - sx0 + 1, sy1 - (sy0 & ~0x07) + 1, src->stride);
+
+    _screen_h->clip = clip;
+}
 
-    /* As long as it is a valid rectangle */
-    if((x1 - x0) > 4 && (y1 - y0) > 4)
+/*!
+    @brief    Mirrors or rotates a surface into another one, or into the display buffer. For example,
+    a portrait UI is drawn on a 48x84 surface and rotated by 90 degrees into the display buffer before
+    the refresh. The work is done on 8x8 blocks, transposed with a few word operations, and a lookup
+    table mirrors the columns, so no pixel is handled on its own. The clip and raster operation are ignored.
+    Mirrors and 180 degree rotations also work in place (dst same as src), if the height is a multiple of 8.
+    @param    src   The source surface
+    @param    dst   The destination surface with the transformed size, NULL for the display buffer
+    @param    op    The transform (PCD8544_ROTATE_90, _180, _270, PCD8544_MIRROR_X, _MIRROR_Y or PCD8544_TRANSPOSE)
+    @return         Success(True) or Failure(False) if the sizes do not match.
+*/
+bool PCD8544_transform(const pcd_8544_surface_t *src, const pcd_8544_surface_t *dst, uint8_t op)
+{
+    pcd_8544_surface_t screen = { .buffer = _screen_h->buffer, .width = LCDWIDTH, .height = LCDHEIGHT, .stride = LCDWIDTH };
+    if(!dst) dst = &screen;
+
+    /* Sanity check */
+    if(!src || !src->buffer || !dst->buffer) return false;
+
+    bool transpose = op & PCD8544_TRANSPOSE;
+    if(dst->width != (transpose ? src->height : src->width) || dst->height != (transpose ? src->width : src->height))
+        return false;
+
+    if(src->buffer != dst->buffer)
+    {
+        _transform(src->buffer, src->width, src->height, src->stride, dst->buffer, dst->stride, op);
+        return true;
+    }
+
+    /* In place - Pairs of columns and pairs of banks are swapped */
+    if(transpose || (src->height & 0x07) || src->stride != dst->stride) return false;
+
+    uint8_t banks = src->height >> 3;
+
+    if(op & PCD8544_MIRROR_X)
     {
-        if(fill)
+        for(uint8_t bank = 0; bank < banks; bank++)
         {
-            /* Draw a normal filed rectangle and unset the necessary bits */
-            PCD8544_draw_rectangle(x0, x1, y0, y1, color, true);
-
-            /* Upper left corner */
-            PCD8544_set_pixel(x0, y0, !color);
-            PCD8544_set_pixel(x0 + 1, y0, !color);
-            PCD8544_set_pixel(x0, y0 + 1, !color);
-
-            /* Upper right corner */
-            PCD8544_set_pixel(x1, y0, !color);
-            PCD8544_set_pixel(x1 - 1, y0, !color);
-            PCD8544_set_pixel(x1, y0 + 1, !color);
-
-            /* Lower left corner */
-            PCD8544_set_pixel(x0, y1, !color);
-            PCD8544_set_pixel(x0 + 1, y1, !color);
-            PCD8544_set_pixel(x0, y1 - 1, !color);
-
-            /* Lower right corner */
-            PCD8544_set_pixel(x1, y1, !color);
-            PCD8544_set_pixel(x1 - 1, y1, !color);
-            PCD8544_set_pixel(x1, y1 - 1, !color);
+            uint8_t *row = src->buffer + bank * src->stride;
+            for(uint8_t i = 0, j = src->width - 1; i < j; i++, j--) SWAP_VAR(row[i], row[j]);
         }
-        else
+    }
+
+    if(op & PCD8544_MIRROR_Y)
+    {
+        for(uint8_t bank = 0; bank < (banks + 1) / 2; bank++)
         {
-            PCD8544_set_pixel(x0 + 1, y0 + 1, color);
-            PCD8544_set_pixel(x1 - 1, y0 + 1, color);
-            PCD8544_set_pixel(x0 + 1, y1 - 1, color);
-            PCD8544_set_pixel(x1 - 1, y1 - 1, color);
-            PCD8544_draw_hline(x0 + 2, y0, x1 - x0 - 3, color);
-            PCD8544_draw_hline(x0 + 2, y1, x1 - x0 - 3, color);
-            PCD8544_draw_vline(x0, y0 + 2, y1 - y0 - 3, color);
-            PCD8544_draw_vline(x1, y0 + 2, y1 - y0 - 3, color);
+            uint8_t *top = src->buffer + bank * src->stride;
+            uint8_t *bot = src->buffer + (banks - 1 - bank) * src->stride;
+
+            for(uint8_t i = 0; i < src->width; i++)
+            {
+                uint8_t byte = _bit_reverse[top[i]];
+                top[i] = _bit_reverse[bot[i]];
+                bot[i] = byte;
+            }
         }
     }
+
+    return true;
 }
 
 /**********************************************************/
-/************************ BITMAPS *************************/
+/************************ GREYSCALE ***********************/
 /**********************************************************/
 
 /*!
-    @brief    Draws a bitmap on the screen.
-    @param    bitmap    The bitmap array
-    @param    x0        Leftmost x-coordinate
-    @param    y0        Leftmost y-coordinate
-    @param    len_x     The width of the bitmap
-    @param    len_y     The height of the bitmap
+    @brief    Starts the temporal greyscale mode. From now on, every PCD8544_grey_tick() sends the
+    next frame of the cycle (MSB, LSB and MSB plane) straight out of the planes. Called at a fixed
+    rate, e.g. from a timer interrupt, the weights give 4 grey levels. Until PCD8544_grey_stop(), the
+    refresh and command functions return false without sending anything, drawing in the buffer or
+    in other surfaces is fine.
+    Needs PCD8544_DMA_ACTIVE, a blocking transfer of a full frame from the timer interrupt would
+    take most of the CPU time.
+    @param    grey   The scheduler state, used until the mode is stopped
+    @param    lsb    The low plane (weight 1), PCD8544_BUFFER_SZ bytes
+    @param    msb    The high plane (weight 2), PCD8544_BUFFER_SZ bytes
+    @return          Success(True) or Failure(False) on invalid arguments, a transfer underway or no DMA.
 */
-void PCD8544_draw_bitmap(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y)
+bool PCD8544_grey_start(pcd_8544_grey_t *grey, const uint8_t *lsb, const uint8_t *msb)
 {
-    /* Illegal format of the bitmap or initial position */
-    if(x0 >= LCDWIDTH || y0 >= LCDHEIGHT) return;
+    /* Sanity check */
+    if(!grey || !lsb || !msb || _screen_h->grey) return false;
+
+    #ifdef PCD8544_DMA_ACTIVE
+        if(_screen_h->dma_transfer) return false;
+    #else
+        return false;
+    #endif
 
-    /* Fix drawing lengths */
-    uint8_t draw_ylen = (((uint16_t)y0 + len_y) >= LCDHEIGHT) ? (LCDHEIGHT - y0) : len_y;
-    uint8_t draw_xlen = (((uint16_t)y0 + len_y) >= LCDWIDTH) ? (LCDWIDTH - x0) : len_x;
+    grey->lsb = lsb;
+    grey->msb = msb;
+    grey->pending = false;
+    grey->frame = 0;
+    grey->frames = grey->dropped = 0;
 
-    for(uint8_t j = 0; j < draw_ylen; j++)
-    {
-        /* Since we use the opt version of set, we calculate it ourselves */
-        uint8_t mask = 1 << ((y0 + j) & 0x07);
-        uint8_t bmp_shift = (j & 0x07);
-        uint16_t pos = ((y0 + j) >> 3) * LCDWIDTH + x0;
-        uint16_t pos_src = (j >> 3) * len_x;
+    /* Enabled last, the tick can interrupt at any point */
+    _screen_h->grey = grey;
 
-        for(uint8_t i = 0; i < draw_xlen; i++)
-        {
-            bool bmp_color = _get_bmp_pixel_opt(bitmap, pos_src + i, bmp_shift);
-            _set_single_pixel_opt(pos + i, mask, bmp_color);
-        }
-    }
+    return true;
 }
 
 /*!
-    @brief    Draws a bitmap on the screen.
-    Optimized version that draws bitmaps with height a multiple of 8
-    and that start from a multiple of 8 y-coordinate.
-    Basically we draw from the start of a bank continuously.
+    @brief    Changes the planes being shown, at the start of the next cycle, so that a cycle
+    never mixes old and new planes. With two pairs of planes, one is drawn while the other is shown.
+    The old planes are in use until PCD8544_grey_t.pending is cleared by the tick.
+    @param    lsb    The low plane (weight 1)
+    @param    msb    The high plane (weight 2)
+*/
+void PCD8544_grey_show(const uint8_t *lsb, const uint8_t *msb)
+{
+    pcd_8544_grey_t *grey = _screen_h->grey;
+    if(!grey || !lsb || !msb) return;
+
+    /* The tick must not pick up half of the pair */
+    grey->pending = false;
+    grey->next_lsb = lsb;
+    grey->next_msb = msb;
+    grey->pending = true;
+}
 
-    @param    bitmap    The bitmap array
-    @param    x0        Leftmost x-coordinate
-    @param    y0        Leftmost y-coordinate
-    @param    len_x     The width of the bitmap
-    @param    len_y     The height of the bitmap
+/*!
+    @brief    Sends the next frame of the greyscale cycle. Meant to be called from a timer interrupt
+    at a fixed rate, it only picks the plane and starts its transfer (a single full frame, the display
+    RAM address is back at the origin after each one). A tick that finds the previous frame
+    still being sent is dropped and counted, the SPI clock is too slow for the tick rate.
+    The sustained SPI bandwidth is the tick rate times PCD8544_BUFFER_SZ bytes and the grey
+    levels flicker at the tick rate over PCD8544_GREY_CYCLE. Does nothing when the mode is stopped,
+    which is always the case without DMA.
 */
-void PCD8544_draw_bitmap_opt8(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uint8_t len_x, uint8_t len_y)
+void PCD8544_grey_tick()
 {
-    /* Illegal format of the bitmap or initial position or height */
-    if(x0 >= LCDWIDTH || y0 >= LCDHEIGHT) return;
-    if((y0 & 0x07) || (len_y & 0x07)) return;
+    if(!_screen_h) return;
 
-    /* Fix drawing length */
-    if(((uint16_t)y0 + len_y) >= LCDHEIGHT) len_y = LCDHEIGHT - y0;
-    if(((uint16_t)x0 + len_x) >= LCDWIDTH) len_x = LCDWIDTH - x0;
+    pcd_8544_grey_t *grey = _screen_h->grey;
+    if(!grey) return;
 
-    uint8_t full_banks = len_y >> 3;
-    uint16_t pos = (y0 >>3) * LCDWIDTH + x0;
-    uint16_t pos_src = 0;
+    #ifdef PCD8544_DMA_ACTIVE
+        if(_screen_h->dma_transfer)
+        {
+            grey->dropped++;
+            return;
+        }
+    #endif
 
-    for(uint8_t j = 0; j < full_banks; j++)
+    /* New planes at the start of a cycle */
+    if(!grey->frame && grey->pending)
     {
-        ASSERT_DEBUG((pos) >= LCDBUFFER_SZ, "Error at PCD8544_draw_bitmap_opt8 -> %d\n", pos);
-        ASSERT_DEBUG((pos_src) >= (len_x*len_y), "Error at PCD8544_draw_bitmap_opt8 -> %d\n", pos_src);
-
-        memcpy(_screen_h->buffer + pos, bitmap + pos_src, len_x * sizeof(uint8_t));
-        pos += LCDWIDTH;
-        pos_src += len_x;
+        grey->lsb = grey->next_lsb;
+        grey->msb = grey->next_msb;
+        grey->pending = false;
     }
+
+    /* The MSB plane is shown in frames 0 and 2 */
+    const uint8_t *plane = (grey->frame == 1) ? grey->lsb : grey->msb;
+    if(_send_packet((uint8_t *)plane, LCDBUFFER_SZ, true)) grey->frames++;
+
+    grey->frame = (grey->frame + 1) % PCD8544_GREY_CYCLE;
+}
+
+/*!
+    @brief    Stops the temporal greyscale mode, once the frame being sent is complete.
+    The display keeps the last frame until the next refresh.
+*/
+void PCD8544_grey_stop()
+{
+    _screen_h->grey = NULL;
+    _wait_transfer();
 }
 
 /**********************************************************/
 /************************* TEXT ***************************/
 /**********************************************************/
 
+/*!
+    @brief    Gets the font of a text option. Internal routine.
+    @param    option    The options (font and potential centering)
+    @return             The font, or NULL for an illegal option
+*/
+static const _font_t *_get_font(uint8_t option)
+{
+    switch(option & FONT_MASK)
+    {
+        case LARGE_FONT:  return &_large_font;
+        case MEDIUM_FONT: return &_medium_font;
+        case SMALL_FONT:  return &_small_font;
+        default:          return NULL;
+    }
+}
+
+/*!
+    @brief    Copies the columns of a character to a buffer. Internal routine.
+    @param    font      The font
+    @param    c         The character
+    @param    buffer    The columns, the font's width in bytes
+    @return             Printable(True) or not(False), in which case nothing is copied.
+*/
+static bool _get_glyph(const _font_t *font, char c, uint8_t *buffer)
+{
+    const char offset = 0x20; /* For now this is constant - TODO No big number fonts */
+    if(c < offset) return false;
+
+    const uint8_t *src = font->glyphs + (uint16_t)(c - offset) * font->byte_num;
+
+    /* Small font has to be decoded since the bytes are packed - 4 columns of 6 bits in 3 bytes */
+    if(font->byte_num < font->width)
+    {
+        buffer[0] = (src[0] & 0xfc) >> 2;
+        buffer[1] = ((src[0] & 0x03) << 4) | ((src[1] & 0xf0) >> 4);
+        buffer[2] = ((src[1] & 0x0f) << 2) | ((src[2] & 0xc0) >> 6);
+        buffer[3] = src[2] & 0x3f;
+    }
+    else
+    {
+        memcpy(buffer, src, font->byte_num * sizeof(uint8_t));
+    }
+
+    return true;
+}
+
 /*!
     @brief    Set the cursor position for the default printer.
     @param    x  x-coordinate
@@ -1056,8 +3189,8 @@ void PCD8544_draw_bitmap_opt8(const uint8_t *bitmap, uint8_t x0, uint8_t y0, uin
 */
 void PCD8544_coord(uint8_t x, uint8_t y)
 {
-    if(x < LCDWIDTH) _screen_h->x_pos = x;
-    if(y < LCDHEIGHT) _screen_h->y_pos = y >> 3;
+    if(x < TARGET_WIDTH) _screen_h->x_pos = x;
+    if(y < TARGET_HEIGHT) _screen_h->y_pos = y >> 3;
 }
 
 /*!
@@ -1082,40 +3215,14 @@ void PCD8544_coord(uint8_t x, uint8_t y)
 void PCD8544_print_str(const char *str, uint8_t option, bool invert)
 {
     /* Sanity check */
-    if(!str) return;
+    const _font_t *font = _get_font(option);
+    if(!str || !font) return;
 
-    uint8_t width, shift, byte_num, *font;
-    const char offset = 0x20; /* For now this is constant - TODO No big number fonts */
+    uint8_t width = font->width, shift = 0;
 
-    /* Get the parameters of the text */
-    switch(option & FONT_MASK)
-    {
-        case LARGE_FONT:
-        {
-            shift = 0;
-            width = 6;
-            byte_num = 6;
-            font = (uint8_t *)large_font; // For Compiler warnings //
-            break;
-        }
-        case MEDIUM_FONT:
-        {
-            shift = (option & ALIGMENT_MASK) >> 1; /* Only up or bottom alignment for medium */
-            width = 5;
-            byte_num = 5;
-            font = (uint8_t *)medium_font; // For Compiler warnings //
-            break;
-        }
-        case SMALL_FONT:
-        {
-            shift = option & ALIGMENT_MASK;
-            width = 4;
-            byte_num = 3;
-            font = (uint8_t *)small_font; // For Compiler warnings //
-            break;
-        }
-        default: return; /* Illegal option */
-    }
+    /* Alignment in the bank - Only up or bottom alignment for medium, none for large */
+    if(font == &_small_font) shift = option & ALIGMENT_MASK;
+    else if(font == &_medium_font) shift = (option & ALIGMENT_MASK) >> 1;
 
     /* Print buffer in case we need to edit a character */
     uint8_t buffer[6];
@@ -1123,38 +3230,18 @@ void PCD8544_print_str(const char *str, uint8_t option, bool invert)
     for(; *str; str++)
     {
         /* Screen bounds exceeded or newline found */
-        if((_screen_h->x_pos + width) >= LCDWIDTH || *str == '\n')
+        if((_screen_h->x_pos + width) >= TARGET_WIDTH || *str == '\n')
         {
             _screen_h->x_pos = 0;
             _screen_h->y_pos++;
         }
 
         /* Screen bounds exceeded, reset back to start */
-        if(_screen_h->y_pos >= LCDHEIGHT/8) _screen_h->y_pos = 0;
+        if(_screen_h->y_pos >= TARGET_BANKS) _screen_h->y_pos = 0;
 
-        if(*str >= offset)
+        if(_get_glyph(font, *str, buffer))
         {
-            uint16_t dest_pos = (uint16_t)_screen_h->y_pos * LCDWIDTH + _screen_h->x_pos;
-            uint16_t src_pos = (*str - offset) * byte_num;
-
-            /* Copy to the print buffer */
-            memcpy(buffer, font + src_pos, byte_num * sizeof(uint8_t));
-
-            /* Small font has to be decoded since the bytes are packed */
-            if((option & FONT_MASK) == SMALL_FONT)
-            {
-                /* Unpack the 3 bytes into 4 */
-                buffer[3] = (buffer[0] & 0xfc) >> 2;
-                buffer[4] = ((buffer[0] & 0x03) << 4) | ((buffer[1] & 0xf0) >> 4);
-                buffer[5] = ((buffer[1] & 0x0f) << 2) | ((buffer[2] & 0xc0) >> 6);
-                uint8_t temp = buffer[2] & 0x3f;
-
-                /* Correct position */
-                buffer[0] = buffer[3];
-                buffer[1] = buffer[4];
-                buffer[2] = buffer[5];
-                buffer[3] = temp;
-            }
+            uint16_t dest_pos = (uint16_t)_screen_h->y_pos * TARGET_STRIDE + _screen_h->x_pos;
 
             /* Shifting */
             if(shift)
@@ -1168,7 +3255,23 @@ void PCD8544_print_str(const char *str, uint8_t option, bool invert)
                 for(uint8_t i = 0; i < width; i++) buffer[i] = ~buffer[i];
             }
 
-            memcpy(_screen_h->buffer + dest_pos, buffer, width * sizeof(uint8_t));
+            /* Rows of the bank inside the clip rectangle */
+            const pcd_8544_rect_t *clip = &_screen_h->clip;
+            uint8_t mask = _bank_mask(_screen_h->y_pos, clip->y0, clip->y1);
+            bool inside = _screen_h->x_pos >= clip->x0 && (_screen_h->x_pos + width - 1) <= clip->x1;
+
+            if(_screen_h->rop == PCD8544_ROP_COPY && mask == 0xff && inside)
+            {
+                memcpy(TARGET_BUFFER + dest_pos, buffer, width * sizeof(uint8_t));
+            }
+            else if(mask)
+            {
+                for(uint8_t i = 0; i < width; i++)
+                {
+                    uint8_t x = _screen_h->x_pos + i;
+                    if(x >= clip->x0 && x <= clip->x1) _rop_byte(dest_pos + i, mask, buffer[i]);
+                }
+            }
 
             _screen_h->x_pos += width;
         }
@@ -1189,40 +3292,60 @@ void PCD8544_print_str(const char *str, uint8_t option, bool invert)
 void PCD8544_print_fstr(const char *str, uint8_t option, uint8_t x, uint8_t y, bool invert)
 {
     /* Sanity check */
-    if(!str) return;
+    const _font_t *font = _get_font(option);
+    if(!str || !font) return;
 
-    uint8_t width, height, byte_num, *font;
-    const char offset = 0x20; /* For now this is constant - TODO No big number fonts */
+    uint8_t width = font->width, height = font->height;
 
-    /* Get the parameters of the text */
-    switch(option & FONT_MASK)
+    /* Print buffer in case we need to edit a character */
+    uint8_t buffer[6];
+
+    for(; *str; str++)
     {
-        case LARGE_FONT:
-        {
-            height = 8;
-            width = 6;
-            byte_num = 6;
-            font = (uint8_t *)large_font; // For Compiler warnings //
-            break;
-        }
-        case MEDIUM_FONT:
+        /* Screen bounds exceeded or newline found */
+        if((x + width) >= TARGET_WIDTH || *str == '\n')
         {
-            height = 7;
-            width = 5;
-            byte_num = 5;
-            font = (uint8_t *)medium_font; // For Compiler warnings //
-            break;
+            x = 0;
+            y += height;
         }
-        case SMALL_FONT:
+
+        /* Screen bounds exceeded, reset back to start */
+        if(y >= TARGET_HEIGHT) y = 0;
+
+        if(_get_glyph(font, *str, buffer))
         {
-            height = 6;
-            width = 4;
-            byte_num = 3;
-            font = (uint8_t *)small_font; // For Compiler warnings //
-            break;
+            /* Invert option */
+            if(invert)
+            {
+                for(uint8_t i = 0; i < width; i++) buffer[i] = ~buffer[i];
+            }
+
+            /* Draw the bitmap */
+            PCD8544_draw_bitmap(buffer, x, y, width, height * sizeof(uint8_t));
+
+            x += width;
         }
-        default: return; /* Illegal option */
     }
+}
+
+/*!
+    @brief    Draws a string on any xy coordinate, like PCD8544_print_fstr(), with the characters
+    scaled up by an integer factor. Large numerals and titles come from the small fonts in flash.
+    @param    str       The string to print
+    @param    option    Font type (Alignment is not needed here)
+    @param    x         Starting x-coordinate
+    @param    y         Starting y-coordinate
+    @param    scale     The factor, 1 to 4
+    @param    invert    Flag to invert the text, if true inverts (black bg with white character)
+    otherwise left as is.
+*/
+void PCD8544_print_fstr_scaled(const char *str, uint8_t option, uint8_t x, uint8_t y, uint8_t scale, bool invert)
+{
+    /* Sanity check */
+    const _font_t *font = _get_font(option);
+    if(!str || !font || !scale || scale > 4) return;
+
+    uint8_t width = font->width, height = font->height;
 
     /* Print buffer in case we need to edit a character */
     uint8_t buffer[6];
@@ -1230,48 +3353,27 @@ void PCD8544_print_fstr(const char *str, uint8_t option, uint8_t x, uint8_t y, b
     for(; *str; str++)
     {
         /* Screen bounds exceeded or newline found */
-        if((x + width) >= LCDWIDTH || *str == '\n')
+        if((x + width * scale) >= TARGET_WIDTH || *str == '\n')
         {
             x = 0;
-            y += height;
+            y += height * scale;
         }
 
         /* Screen bounds exceeded, reset back to start */
-        if(y >= LCDHEIGHT) y = 0;
+        if(y >= TARGET_HEIGHT) y = 0;
 
-        if(*str >= offset)
+        if(_get_glyph(font, *str, buffer))
         {
-            uint16_t src_pos = (*str - offset) * byte_num;
-
-            /* Copy to the print buffer */
-            memcpy(buffer, font + src_pos, byte_num * sizeof(uint8_t));
-
-            /* Small font has to be decoded since the bytes are packed */
-            if((option & FONT_MASK) == SMALL_FONT)
-            {
-                /* Unpack the 3 bytes into 4 */
-                buffer[3] = (buffer[0] & 0xfc) >> 2;
-                buffer[4] = ((buffer[0] & 0x03) << 4) | ((buffer[1] & 0xf0) >> 4);
-                buffer[5] = ((buffer[1] & 0x0f) << 2) | ((buffer[2] & 0xc0) >> 6);
-                uint8_t temp = buffer[2] & 0x3f;
-
-                /* Correct position */
-                buffer[0] = buffer[3];
-                buffer[1] = buffer[4];
-                buffer[2] = buffer[5];
-                buffer[3] = temp;
-            }
-
             /* Invert option */
             if(invert)
             {
                 for(uint8_t i = 0; i < width; i++) buffer[i] = ~buffer[i];
             }
 
-            /* Draw the bitmap */
-            PCD8544_draw_bitmap(buffer, x, y, width, height * sizeof(uint8_t));
+            /* Draw the scaled bitmap */
+            PCD8544_draw_bitmap_scaled(buffer, x, y, width, height, scale);
 
-            x += width;
+            x += width * scale;
         }
     }
 }
@@ -0,0 +1,93 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+#include <pcd_8544_tilemap.h>   /* External header */
+
+/* Drawn for the cells outside of a map that does not wrap */
+static const uint8_t _blank_tile[PCD8544_TILE_SZ] = { 0 };
+
+/*!
+    @brief    Initializes a tilemap, with no scrolling and no wrapping.
+    @param    tm       The tilemap
+    @param    atlas    The tiles, PCD8544_TILE_SZ bytes each
+    @param    map      The tile indices, row-major
+    @param    width    The map width in tiles
+    @param    height   The map height in tiles
+*/
+void PCD8544_tilemap_init(pcd_8544_tilemap_t *tm, const uint8_t *atlas, const uint8_t *map, uint8_t width, uint8_t height)
+{
+    tm->atlas = atlas;
+    tm->map = map;
+    tm->width = width;
+    tm->height = height;
+    tm->scroll_x = tm->scroll_y = 0;
+    tm->wrap = false;
+}
+
+/*!
+    @brief    Sets the scroll offset of a tilemap.
+    @param    tm   The tilemap
+    @param    x    The map x-coordinate shown at the left of the window, in pixels
+    @param    y    The map y-coordinate shown at the top of the window, in pixels
+*/
+void PCD8544_tilemap_scroll(pcd_8544_tilemap_t *tm, int16_t x, int16_t y)
+{
+    tm->scroll_x = x;
+    tm->scroll_y = y;
+}
+
+/*!
+    @brief    Draws a tilemap inside a window of the screen.
+    Each tile is a blit of 8 bytes. When y0 - scroll_y is a multiple of 8 the tiles start at
+    bank boundaries and are copied straight into their bank, else each one is shifted across two banks.
+    The tiles at the edges of the window are clipped. Without wrapping, the cells of the window
+    outside of the map are cleared to white.
+    @param    tm   The tilemap
+    @param    x0   Left-most x-coordinate of the window
+    @param    x1   Right-most x-coordinate of the window
+    @param    y0   Uppermost y-coordinate of the window
+    @param    y1   Lowermost y-coordinate of the window
+    @return        Success(True) or Failure(False) if the clip stack is full.
+*/
+bool PCD8544_tilemap_draw(const pcd_8544_tilemap_t *tm, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    if(!tm->atlas || !tm->map || !tm->width || !tm->height) return true;
+
+    /* Just in case mistakes were made */
+    if(x0 > x1) { uint8_t t = x0; x0 = x1; x1 = t; }
+    if(y0 > y1) { uint8_t t = y0; y0 = y1; y1 = t; }
+
+    if(!PCD8544_clip_push(x0, x1, y0, y1)) return false;
+
+    /* Map pixels of the window corners - Tiles that cover them (floor division) */
+    int16_t mx0 = tm->scroll_x, my0 = tm->scroll_y;
+    int16_t tx0 = mx0 >> 3, tx1 = (mx0 + x1 - x0) >> 3;
+    int16_t ty0 = my0 >> 3, ty1 = (my0 + y1 - y0) >> 3;
+
+    for(int16_t ty = ty0; ty <= ty1; ty++)
+    {
+        int16_t row = ty;
+        if(tm->wrap) row = ((row % tm->height) + tm->height) % tm->height;
+
+        const uint8_t *map_row = (row >= 0 && row < tm->height) ? tm->map + row * tm->width : NULL;
+        int16_t sy = y0 + ty * 8 - my0;
+
+        for(int16_t tx = tx0; tx <= tx1; tx++)
+        {
+            int16_t col = tx;
+            if(tm->wrap) col = ((col % tm->width) + tm->width) % tm->width;
+
+            /* Outside of the map - A blank tile, so that nothing is left from the previous draw */
+            const uint8_t *tile = _blank_tile;
+            if(map_row && col >= 0 && col < tm->width) tile = tm->atlas + map_row[col] * PCD8544_TILE_SZ;
+
+            PCD8544_draw_bitmap_s(tile, x0 + tx * 8 - mx0, sy, PCD8544_TILE_SZ, PCD8544_TILE_SZ);
+        }
+    }
+
+    PCD8544_clip_pop();
+
+    return true;
+}
@@ -1,5 +1,6 @@
 #include "main.h"
 #include "stm32f4xx_it.h"
+#include <pcd_8544.h>
 
 /******************************************************************************/
 /*           Cortex-M4 Processor Interruption and Exception Handlers          */
@@ -72,6 +73,9 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
     HAL_IncTick();
+
+    /* Next frame of the temporal greyscale mode, if it is running */
+    PCD8544_grey_tick();
 }
 
 /**
@@ -0,0 +1,242 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+#include <pcd_8544_anim.h>      /* External header */
+
+#include <string.h>             /* For memset */
+
+/* Screen size and parameters */
+#define LCDWIDTH            PCD8544_WIDTH
+#define LCDHEIGHT           PCD8544_HEIGHT
+#define LCDBUFFER_SZ        PCD8544_BUFFER_SZ
+
+/**********************************************************/
+/************************ INTERNAL ************************/
+/**********************************************************/
+
+/*!
+    @brief    Returns a byte of the encoded stream, the frame itself or its XOR with the previous one. Internal routine.
+    @param    prev    The previous frame, NULL for a keyframe
+    @param    frame   The frame
+    @param    i       The byte index
+    @return           The byte to encode
+*/
+static inline uint8_t _delta(const uint8_t *prev, const uint8_t *frame, uint16_t i)
+{
+    return prev ? frame[i] ^ prev[i] : frame[i];
+}
+
+/*!
+    @brief    Marks a range of the bank stream as changed. Internal routine.
+    @param    player  The player
+    @param    pos     The first byte
+    @param    len     The number of bytes, can span multiple banks
+*/
+static void _mark(pcd_8544_player_t *player, uint16_t pos, uint16_t len)
+{
+    while(len)
+    {
+        uint8_t bank = pos / LCDWIDTH, x = pos % LCDWIDTH;
+        uint16_t n = (len < LCDWIDTH - x) ? len : LCDWIDTH - x;
+
+        PCD8544_damage_add(&player->dirty, x, x + n - 1, bank << 3, bank << 3);
+
+        pos += n;
+        len -= n;
+    }
+}
+
+/*!
+    @brief    Applies a frame to the buffer. Keyframes overwrite it and mark the whole screen,
+    the rest are XORed on it and mark only the bytes they change. Runs of zeros are skipped. Internal routine.
+    @param    player  The player
+    @param    frame   The frame index
+*/
+static void _apply(pcd_8544_player_t *player, uint16_t frame)
+{
+    const uint8_t *data = player->anim->frames[frame];
+    uint8_t *buffer = player->buffer;
+    bool key = PCD8544_anim_keyframe(player->anim, frame);
+
+    if(key) _mark(player, 0, LCDBUFFER_SZ);
+
+    for(uint16_t pos = 0; pos < LCDBUFFER_SZ; )
+    {
+        uint8_t header = *data++;
+        uint16_t len = (header & PCD8544_RLE_RUN) ? (header & ~PCD8544_RLE_RUN) + 2 : header + 1;
+
+        /* A stream longer than the screen is cut */
+        if(len > LCDBUFFER_SZ - pos) len = LCDBUFFER_SZ - pos;
+
+        if(header & PCD8544_RLE_RUN)
+        {
+            uint8_t byte = *data++;
+
+            if(key) memset(buffer + pos, byte, len);
+            else if(byte)
+            {
+                for(uint16_t i = 0; i < len; i++) buffer[pos + i] ^= byte;
+                _mark(player, pos, len);
+            }
+        }
+        else if(key) memcpy(buffer + pos, data, len);
+        else
+        {
+            /* Only the span between the first and the last changed byte is marked */
+            int16_t first = -1, last = -1;
+
+            for(uint16_t i = 0; i < len; i++)
+            {
+                if(!data[i]) continue;
+
+                buffer[pos + i] ^= data[i];
+                if(first < 0) first = i;
+                last = i;
+            }
+
+            if(first >= 0) _mark(player, pos + first, last - first + 1);
+        }
+
+        /* Literal bytes follow their header, even the cut ones */
+        if(!(header & PCD8544_RLE_RUN)) data += (header + 1);
+        pos += len;
+    }
+}
+
+/**********************************************************/
+/************************ ENCODING ************************/
+/**********************************************************/
+
+/*!
+    @brief    Checks if a frame of an animation is a keyframe.
+    @param    anim    The animation
+    @param    frame   The frame index
+    @return           Keyframe(True) or delta frame(False).
+*/
+bool PCD8544_anim_keyframe(const pcd_8544_anim_t *anim, uint16_t frame)
+{
+    return !frame || (anim->keyframe_interval && !(frame % anim->keyframe_interval));
+}
+
+/*!
+    @brief    Encodes a full screen frame of an animation. Each frame is encoded against the previous
+    one, as it was drawn, so a sequence is encoded by passing the previous frame along with each frame.
+    Runs of three or more equal bytes are stored as runs, everything else as literals, so a run
+    never costs more than the literals it replaces.
+    @param    prev    The previous frame, NULL for a keyframe
+    @param    frame   The frame (PCD8544_BUFFER_SZ bytes, the display's layout)
+    @param    out     The encoded frame
+    @param    out_sz  The size of out, at most PCD8544_ANIM_FRAME_MAX bytes are needed
+    @return           The size of the encoded frame, 0 if it does not fit in out.
+*/
+uint16_t PCD8544_anim_encode(const uint8_t *prev, const uint8_t *frame, uint8_t *out, uint16_t out_sz)
+{
+    uint16_t k = 0;
+
+    for(uint16_t i = 0; i < LCDBUFFER_SZ; )
+    {
+        uint8_t byte = _delta(prev, frame, i);
+        uint16_t run = 1;
+
+        while(i + run < LCDBUFFER_SZ && run < 129 && _delta(prev, frame, i + run) == byte) run++;
+
+        if(run >= 3)
+        {
+            if(k + 2 > out_sz) return 0;
+            out[k++] = PCD8544_RLE_RUN | (run - 2);
+            out[k++] = byte;
+            i += run;
+            continue;
+        }
+
+        /* Literals end before the next three equal bytes, which are cheaper as a run */
+        uint16_t start = i, len = 0;
+        while(i < LCDBUFFER_SZ && len < 128)
+        {
+            if(i + 2 < LCDBUFFER_SZ && _delta(prev, frame, i + 1) == _delta(prev, frame, i) &&
+               _delta(prev, frame, i + 2) == _delta(prev, frame, i)) break;
+            i++;
+            len++;
+        }
+
+        if(k + 1 + len > out_sz) return 0;
+        out[k++] = len - 1;
+        for(uint16_t j = 0; j < len; j++) out[k++] = _delta(prev, frame, start + j);
+    }
+
+    return k;
+}
+
+/**********************************************************/
+/************************ PLAYBACK ************************/
+/**********************************************************/
+
+/*!
+    @brief    Initializes a player. Nothing is drawn until the first frame is played.
+    @param    player   The player
+    @param    anim     The animation
+    @param    buffer   The display buffer, as given to PCD8544_init()
+    @param    loop     Start over after the last frame(True) or stop(False)
+*/
+void PCD8544_player_init(pcd_8544_player_t *player, const pcd_8544_anim_t *anim, uint8_t *buffer, bool loop)
+{
+    memset(player, 0, sizeof(*player));
+    player->anim = anim;
+    player->buffer = buffer;
+    player->loop = loop;
+
+    PCD8544_damage_clear(&player->dirty);
+}
+
+/*!
+    @brief    Plays the next frame. The frame is applied in place to the display buffer,
+    which must still hold the previous frame, and only the changed columns of each bank
+    are sent to the display. The drawing state (clip, raster operation, target) is not used.
+    @param    player   The player
+    @return            Success(True) or Failure(False) in sending the data. The changes that
+                       could not be sent are sent again with the next frame.
+*/
+bool PCD8544_player_next(pcd_8544_player_t *player)
+{
+    if(player->frame >= player->anim->num_frames)
+    {
+        if(!player->loop) return true;
+        player->frame = 0;
+    }
+
+    _apply(player, player->frame++);
+
+    return PCD8544_damage_flush(&player->dirty, NULL, NULL);
+}
+
+/*!
+    @brief    Jumps to a frame and shows it. The frames are applied from the closest keyframe
+    before it, so the cost depends on the keyframe interval. Playback continues after it.
+    @param    player   The player
+    @param    frame    The frame index
+    @return            Success(True) or Failure(False) in sending the data or an invalid frame.
+*/
+bool PCD8544_player_seek(pcd_8544_player_t *player, uint16_t frame)
+{
+    const pcd_8544_anim_t *anim = player->anim;
+    if(frame >= anim->num_frames) return false;
+
+    uint16_t key = anim->keyframe_interval ? frame - frame % anim->keyframe_interval : 0;
+    for(uint16_t i = key; i <= frame; i++) _apply(player, i);
+
+    player->frame = frame + 1;
+
+    return PCD8544_damage_flush(&player->dirty, NULL, NULL);
+}
+
+/*!
+    @brief    Checks if a player has played the last frame. Looping players are never done.
+    @param    player   The player
+    @return            Done(True) or still playing(False).
+*/
+bool PCD8544_player_done(const pcd_8544_player_t *player)
+{
+    return !player->loop && player->frame >= player->anim->num_frames;
+}
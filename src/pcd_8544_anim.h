@@ -0,0 +1,54 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_ANIM_H
+#define __PCD_8544_ANIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes */
+#include <pcd_8544_damage.h>
+
+/* Largest encoded frame - All literals, a header for every 128 bytes */
+#define PCD8544_ANIM_FRAME_MAX      (PCD8544_BUFFER_SZ + (PCD8544_BUFFER_SZ + 127) / 128)
+
+/* Animation - Full screen frames, each one run-length encoded (see PCD8544_RLE_RUN) over the bank bytes.
+ * Keyframes hold the frame itself, the rest hold the XOR of the frame with the previous one, so
+ * unchanged parts are runs of zeros. The first frame is always a keyframe. */
+typedef struct pcd_8544_anim_struct
+{
+    const uint8_t * const *frames;      /* Frame table, made with PCD8544_anim_encode() */
+    uint16_t num_frames;
+    uint16_t keyframe_interval;         /* Every frame with an index multiple of it is a keyframe, 0 for only the first */
+}pcd_8544_anim_t;
+
+/* Player - Applies the frames in place to a buffer, which must hold the previous frame */
+typedef struct pcd_8544_player_struct
+{
+    const pcd_8544_anim_t *anim;
+    uint8_t *buffer;                    /* The display buffer (PCD8544_BUFFER_SZ bytes) */
+    uint16_t frame;                     /* Next frame to play */
+    bool loop;                          /* Start over after the last frame */
+    pcd_8544_damage_t dirty;            /* Changed columns, not sent yet */
+}pcd_8544_player_t;
+
+/* Encoding */
+bool PCD8544_anim_keyframe(const pcd_8544_anim_t *anim, uint16_t frame);
+uint16_t PCD8544_anim_encode(const uint8_t *prev, const uint8_t *frame, uint8_t *out, uint16_t out_sz);
+
+/* Playback */
+void PCD8544_player_init(pcd_8544_player_t *player, const pcd_8544_anim_t *anim, uint8_t *buffer, bool loop);
+bool PCD8544_player_next(pcd_8544_player_t *player);
+bool PCD8544_player_seek(pcd_8544_player_t *player, uint16_t frame);
+bool PCD8544_player_done(const pcd_8544_player_t *player);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_ANIM_H */
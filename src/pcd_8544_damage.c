@@ -0,0 +1,103 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+#include <pcd_8544_damage.h>    /* External header */
+
+#include <string.h>             /* For memset */
+
+/* Screen size and parameters */
+#define LCDWIDTH            PCD8544_WIDTH
+#define LCDHEIGHT           PCD8544_HEIGHT
+
+/**********************************************************/
+/************************* DAMAGE *************************/
+/**********************************************************/
+
+/*!
+    @brief    Marks every bank as intact.
+    @param    damage   The damage
+*/
+void PCD8544_damage_clear(pcd_8544_damage_t *damage)
+{
+    /* No damage is x0 = 0xff and x1 = 0, so that the union is a min/max */
+    memset(damage->x0, 0xff, sizeof(damage->x0));
+    memset(damage->x1, 0, sizeof(damage->x1));
+}
+
+/*!
+    @brief    Marks a rectangle of the screen as damaged. The columns of every bank it
+    touches are extended to cover it.
+    @param    damage   The damage
+    @param    x0       Left-most x-coordinate, can be out of bounds
+    @param    x1       Right-most x-coordinate, can be out of bounds
+    @param    y0       Uppermost y-coordinate, can be out of bounds
+    @param    y1       Lowermost y-coordinate, can be out of bounds
+*/
+void PCD8544_damage_add(pcd_8544_damage_t *damage, int16_t x0, int16_t x1, int16_t y0, int16_t y1)
+{
+    /* Clip to the screen */
+    if(x0 < 0) x0 = 0;
+    if(y0 < 0) y0 = 0;
+    if(x1 >= LCDWIDTH) x1 = LCDWIDTH - 1;
+    if(y1 >= LCDHEIGHT) y1 = LCDHEIGHT - 1;
+    if(x0 > x1 || y0 > y1) return;
+
+    for(uint8_t bank = y0 >> 3; bank <= (y1 >> 3); bank++)
+    {
+        if(x0 < damage->x0[bank]) damage->x0[bank] = x0;
+        if(x1 > damage->x1[bank]) damage->x1[bank] = x1;
+    }
+}
+
+/*!
+    @brief    Redraws the damaged columns of each bank and sends them to the display with
+    PCD8544_refresh_region(). The redraw runs between PCD8544_state_save() and PCD8544_state_restore(),
+    so it draws in the display buffer, over the whole screen, with COPY and solid fills, and it
+    is clipped to the damaged columns of the bank. Without a redraw, the display buffer is sent as it is.
+    A bank is intact again once it is sent, the rest keep their damage for the next flush.
+    @param    damage   The damage
+    @param    redraw   Draws a bank, NULL if the display buffer is already up to date
+    @param    ctx      Passed to the redraw
+    @return            Success(True) or Failure(False) in redrawing and sending the data.
+*/
+bool PCD8544_damage_flush(pcd_8544_damage_t *damage, pcd_8544_redraw_t redraw, void *ctx)
+{
+    pcd_8544_state_t state;
+    bool ret = true;
+
+    if(redraw) PCD8544_state_save(&state);
+
+    for(uint8_t bank = 0; bank < PCD8544_DAMAGE_BANKS; bank++)
+    {
+        uint8_t x0 = damage->x0[bank], x1 = damage->x1[bank];
+        if(x0 > x1) continue;
+
+        uint8_t y0 = bank << 3, y1 = y0 + 7;
+        if(redraw)
+        {
+            if(!PCD8544_clip_push(x0, x1, y0, y1))
+            {
+                ret = false;
+                break;
+            }
+
+            redraw(ctx, x0, x1, y0, y1);
+            PCD8544_clip_pop();
+        }
+
+        if(!PCD8544_refresh_region(x0, x1, y0, y1))
+        {
+            ret = false;
+            continue;
+        }
+
+        damage->x0[bank] = 0xff;
+        damage->x1[bank] = 0;
+    }
+
+    if(redraw) PCD8544_state_restore(&state);
+
+    return ret;
+}
@@ -0,0 +1,221 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+#include <pcd_8544_dither.h>    /* External header */
+
+#include <string.h>             /* For memset */
+
+/* Grey level that splits black from white */
+#define DITHER_MID          128
+
+/**********************************************************/
+/************************ INTERNAL ************************/
+/**********************************************************/
+
+/*!
+    @brief    Draws the bank being built and starts a new one. Internal routine.
+    @param    d    The dithering stream
+*/
+static void _flush(pcd_8544_dither_t *d)
+{
+    if(!d->rows) return;
+
+    /* The first bank can be short, so that the rest start at a bank boundary and are copied as they are */
+    PCD8544_draw_bitmap_s(d->bank, d->x0, d->y - d->rows, d->len_x, d->rows);
+    d->rows = 0;
+}
+
+/*!
+    @brief    Floyd-Steinberg on a row, with a single error line. Internal routine.
+    The line holds the errors of the next row left of x and those of the current row from x on.
+    The errors of the next row are summed in n0-n2 and written once complete, one column behind.
+    @param    d      The dithering stream
+    @param    grey   The row
+    @param    bit    The bit of the row in the bank
+*/
+static void _row_fs(pcd_8544_dither_t *d, const uint8_t *grey, uint8_t bit)
+{
+    int16_t *line = d->error;
+    int16_t right = 0, n0 = 0, n1 = 0, n2 = 0;
+
+    for(uint8_t x = 0; x < d->len_x; x++)
+    {
+        int16_t val = grey[x] + line[x] + right;
+        int16_t e = (val < DITHER_MID) ? val : val - 255;
+        if(val < DITHER_MID) d->bank[x] |= bit;
+
+        right = e * 7 / 16;
+        n0 += e * 3 / 16;
+        n1 += e * 5 / 16;
+        n2 += e / 16;
+
+        if(x) line[x - 1] = n0;
+        n0 = n1;
+        n1 = n2;
+        n2 = 0;
+    }
+
+    line[d->len_x - 1] = n0;
+}
+
+/*!
+    @brief    Atkinson on a row. Internal routine. Same as _row_fs(), with a second line
+    for the errors two rows down, which are added to the next row's when it becomes current.
+    @param    d      The dithering stream
+    @param    grey   The row
+    @param    bit    The bit of the row in the bank
+*/
+static void _row_atkinson(pcd_8544_dither_t *d, const uint8_t *grey, uint8_t bit)
+{
+    int16_t *line = d->error, *below = d->error + d->len_x;
+    int16_t r1 = 0, r2 = 0, n0 = 0, n1 = 0, n2 = 0;
+
+    for(uint8_t x = 0; x < d->len_x; x++)
+    {
+        int16_t val = grey[x] + line[x] + r1;
+        int16_t e = (val < DITHER_MID) ? val : val - 255;
+        if(val < DITHER_MID) d->bank[x] |= bit;
+
+        /* An eighth of the error to each of the 6 neighbours */
+        int16_t q = e / 8;
+
+        r1 = r2 + q;
+        r2 = q;
+        n0 += q;
+        n1 += q + below[x];
+        n2 += q;
+        below[x] = q;
+
+        if(x) line[x - 1] = n0;
+        n0 = n1;
+        n1 = n2;
+        n2 = 0;
+    }
+
+    line[d->len_x - 1] = n0;
+}
+
+/*!
+    @brief    Dithers a row into the bank being built. Internal routine.
+    @param    d      The dithering stream
+    @param    grey   The row
+*/
+static void _row(pcd_8544_dither_t *d, const uint8_t *grey)
+{
+    uint8_t bit = 1 << d->rows;
+    if(!d->rows) memset(d->bank, 0, d->len_x);
+
+    switch(d->method)
+    {
+        case PCD8544_DITHER_FS:
+            _row_fs(d, grey, bit);
+            break;
+
+        case PCD8544_DITHER_ATKINSON:
+            _row_atkinson(d, grey, bit);
+            break;
+
+        case PCD8544_DITHER_BAYER:
+        {
+            /* The matrix is anchored to the screen, so that pieces drawn apart line up.
+               Its 64 levels are steps of 4 grey levels, the threshold is in the middle of each. */
+            const uint8_t *t = bayer_8x8[d->y & 0x07];
+            for(uint8_t x = 0; x < d->len_x; x++)
+                if(grey[x] < (t[(d->x0 + x) & 0x07] << 2) + 2) d->bank[x] |= bit;
+            break;
+        }
+
+        default:
+            for(uint8_t x = 0; x < d->len_x; x++)
+                if(grey[x] < DITHER_MID) d->bank[x] |= bit;
+            break;
+    }
+
+    d->rows++;
+    d->y++;
+
+    /* Banks end at the bank boundaries of the screen */
+    if(!(d->y & 0x07)) _flush(d);
+}
+
+/**********************************************************/
+/************************ DITHERING ***********************/
+/**********************************************************/
+
+/*!
+    @brief    Starts a dithering stream. Rows are dithered as they arrive and every 8 rows
+    the bank is drawn on the draw target, like PCD8544_draw_bitmap_s() (clip and raster operation apply).
+    No full frame copy is kept, only the error lines and the bank being built.
+    @param    d        The dithering stream
+    @param    method   The dithering method (PCD8544_DITHER_*)
+    @param    x0       Leftmost x-coordinate, can be negative
+    @param    y0       Uppermost y-coordinate, can be negative
+    @param    len_x    The width of the rows
+    @param    error    The error lines, PCD8544_DITHER_ERR_SZ(len_x) entries. Only needed by the error diffusion methods.
+    @param    bank     The bank being built, len_x bytes
+    @return            Success(True) or Failure(False) on invalid arguments.
+*/
+bool PCD8544_dither_init(pcd_8544_dither_t *d, uint8_t method, int16_t x0, int16_t y0, uint8_t len_x, int16_t *error, uint8_t *bank)
+{
+    bool diffusion = (method == PCD8544_DITHER_FS || method == PCD8544_DITHER_ATKINSON);
+
+    /* Sanity check */
+    if(!len_x || !bank || method > PCD8544_DITHER_BAYER || (diffusion && !error)) return false;
+
+    d->error = error;
+    d->bank = bank;
+    d->x0 = x0;
+    d->y = y0;
+    d->len_x = len_x;
+    d->method = method;
+    d->rows = 0;
+
+    if(diffusion) memset(error, 0, PCD8544_DITHER_ERR_SZ(len_x) * sizeof(int16_t));
+
+    return true;
+}
+
+/*!
+    @brief    Dithers the next rows of a stream, e.g. as they arrive from a sensor.
+    @param    d        The dithering stream
+    @param    grey     The rows, len_x bytes each (0 is black, 255 is white)
+    @param    stride   The bytes from one row to the next
+    @param    rows     The number of rows
+*/
+void PCD8544_dither_rows(pcd_8544_dither_t *d, const uint8_t *grey, uint16_t stride, uint8_t rows)
+{
+    for(uint8_t i = 0; i < rows; i++, grey += stride) _row(d, grey);
+}
+
+/*!
+    @brief    Ends a dithering stream, drawing the last rows if they do not fill a bank.
+    @param    d        The dithering stream
+*/
+void PCD8544_dither_end(pcd_8544_dither_t *d)
+{
+    _flush(d);
+}
+
+/*!
+    @brief    Draws a greyscale image, dithered. Same as a stream over all of its rows.
+    @param    grey     The image, len_x * len_y bytes (0 is black, 255 is white)
+    @param    x0       Leftmost x-coordinate, can be negative
+    @param    y0       Uppermost y-coordinate, can be negative
+    @param    len_x    The width of the image
+    @param    len_y    The height of the image
+    @param    method   The dithering method (PCD8544_DITHER_*)
+    @param    error    The error lines, PCD8544_DITHER_ERR_SZ(len_x) entries. Only needed by the error diffusion methods.
+    @param    bank     The bank being built, len_x bytes
+*/
+void PCD8544_draw_grey(const uint8_t *grey, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, uint8_t method,
+                       int16_t *error, uint8_t *bank)
+{
+    pcd_8544_dither_t d;
+
+    if(!grey || !PCD8544_dither_init(&d, method, x0, y0, len_x, error, bank)) return;
+
+    PCD8544_dither_rows(&d, grey, len_x, len_y);
+    PCD8544_dither_end(&d);
+}
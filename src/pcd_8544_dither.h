@@ -0,0 +1,55 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_DITHER_H
+#define __PCD_8544_DITHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes - Host builds (PCD8544_DITHER_HOST), like the converter in the tools folder, leave the display out
+ * and provide PCD8544_draw_bitmap_s() themselves, it receives every bank */
+#include <pcd_8544_bayer.h>
+#ifdef PCD8544_DITHER_HOST
+    #include <stdbool.h>
+    void PCD8544_draw_bitmap_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y);
+#else
+    #include <pcd_8544.h>
+#endif
+
+/* Dithering methods */
+#define PCD8544_DITHER_THRESHOLD        0x00        /* Plain threshold at mid grey */
+#define PCD8544_DITHER_FS               0x01        /* Floyd-Steinberg error diffusion */
+#define PCD8544_DITHER_ATKINSON         0x02        /* Atkinson error diffusion, 3/4 of the error, more contrast */
+#define PCD8544_DITHER_BAYER            0x03        /* Ordered 8x8, no error buffer */
+
+/* Size of the error buffer in entries - One line for Floyd-Steinberg, two for Atkinson (it spreads two rows down) */
+#define PCD8544_DITHER_ERR_SZ(width)    (2 * (width))
+
+/* Dithering stream - Greyscale rows (0 is black, 255 is white) go in, bank bytes are drawn every 8 rows */
+typedef struct pcd_8544_dither_struct
+{
+    int16_t *error;             /* Error lines, PCD8544_DITHER_ERR_SZ(len_x) entries, NULL for the other methods */
+    uint8_t *bank;              /* The bank being built, len_x bytes */
+    int16_t x0, y;              /* Position of the next row */
+    uint8_t len_x;              /* Width of the rows */
+    uint8_t method;
+    uint8_t rows;               /* Rows in the bank being built */
+}pcd_8544_dither_t;
+
+/* Dithering */
+bool PCD8544_dither_init(pcd_8544_dither_t *d, uint8_t method, int16_t x0, int16_t y0, uint8_t len_x, int16_t *error, uint8_t *bank);
+void PCD8544_dither_rows(pcd_8544_dither_t *d, const uint8_t *grey, uint16_t stride, uint8_t rows);
+void PCD8544_dither_end(pcd_8544_dither_t *d);
+void PCD8544_draw_grey(const uint8_t *grey, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y, uint8_t method,
+                       int16_t *error, uint8_t *bank);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_DITHER_H */
@@ -0,0 +1,252 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+#include <pcd_8544_layer.h>     /* External header */
+
+#include <string.h>             /* For memset */
+
+/* Screen size and parameters */
+#define LCDWIDTH            PCD8544_WIDTH
+#define LCDHEIGHT           PCD8544_HEIGHT
+
+/**********************************************************/
+/************************ INTERNAL ************************/
+/**********************************************************/
+
+/*!
+    @brief    Marks the area covered by a layer as damaged. Internal routine.
+    @param    comp   The compositor
+    @param    layer  The layer, for its size
+    @param    x      Layer x-coordinate
+    @param    y      Layer y-coordinate
+*/
+static void _add_layer_damage(pcd_8544_compositor_t *comp, const pcd_8544_layer_t *layer, int16_t x, int16_t y)
+{
+    PCD8544_damage_add(&comp->damage, x, x + layer->surface->width - 1, y, y + layer->surface->height - 1);
+}
+
+/*!
+    @brief    Combines a layer with the buffer, within the clip rectangle. Internal routine.
+    @param    layer  The layer
+*/
+static void _draw_layer(const pcd_8544_layer_t *layer)
+{
+    const pcd_8544_surface_t *s = layer->surface;
+
+    switch(layer->blend)
+    {
+        case PCD8544_BLEND_OR:
+            PCD8544_rop(PCD8544_ROP_OR);
+            break;
+
+        case PCD8544_BLEND_AND:
+            PCD8544_rop(PCD8544_ROP_AND);
+            break;
+
+        case PCD8544_BLEND_XOR:
+            PCD8544_rop(PCD8544_ROP_XOR);
+            break;
+
+        default:
+            PCD8544_rop(PCD8544_ROP_COPY);
+
+            /* Masked layers are plain bitmaps (stride equal to the width), checked by PCD8544_layer_blend() */
+            if(layer->mask)
+            {
+                PCD8544_draw_sprite_s(s->buffer, layer->mask, layer->x, layer->y, s->width, s->height);
+                return;
+            }
+            break;
+    }
+
+    PCD8544_blit_surface(s, 0, s->width - 1, 0, s->height - 1, layer->x, layer->y);
+}
+
+/*!
+    @brief    Composes a damaged bank from white, through the visible layers from the bottom to the top. Internal routine.
+    @param    ctx    The compositor
+    @param    x0     Left-most damaged column
+    @param    x1     Right-most damaged column
+    @param    y0     Uppermost row of the bank
+    @param    y1     Lowermost row of the bank
+*/
+static void _compose(void *ctx, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    const pcd_8544_compositor_t *comp = ctx;
+
+    PCD8544_rop(PCD8544_ROP_COPY);
+    PCD8544_draw_rectangle(x0, x1, y0, y1, false, true);
+
+    for(uint8_t i = 0; i < PCD8544_LAYER_MAX; i++)
+    {
+        const pcd_8544_layer_t *l = &comp->layers[i];
+        if(l->used && l->visible) _draw_layer(l);
+    }
+}
+
+/**********************************************************/
+/*********************** COMPOSITOR ***********************/
+/**********************************************************/
+
+/*!
+    @brief    Initializes a compositor without layers. The whole screen is marked as damaged,
+    so the first update composes everything.
+    @param    comp   The compositor
+*/
+void PCD8544_compositor_init(pcd_8544_compositor_t *comp)
+{
+    memset(comp, 0, sizeof(*comp));
+
+    PCD8544_damage_clear(&comp->damage);
+    PCD8544_damage_add(&comp->damage, 0, LCDWIDTH - 1, 0, LCDHEIGHT - 1);
+}
+
+/*!
+    @brief    Adds a layer on top of the others. The layer starts visible at (0, 0).
+    The surface is drawn on by the application, then the changed part is reported
+    with PCD8544_layer_damage().
+    @param    comp      The compositor
+    @param    surface   The layer's surface
+    @param    blend     The blend mode (PCD8544_BLEND_OR, _AND, _XOR or _REPLACE)
+    @return             The layer, or NULL if the compositor is full or the arguments are invalid
+*/
+pcd_8544_layer_t *PCD8544_layer_add(pcd_8544_compositor_t *comp, const pcd_8544_surface_t *surface, uint8_t blend)
+{
+    if(!surface || !surface->buffer || blend > PCD8544_BLEND_REPLACE) return NULL;
+
+    for(uint8_t i = 0; i < PCD8544_LAYER_MAX; i++)
+    {
+        pcd_8544_layer_t *l = &comp->layers[i];
+        if(l->used) continue;
+
+        memset(l, 0, sizeof(*l));
+        l->surface = surface;
+        l->blend = blend;
+        l->visible = l->used = true;
+        l->damage_x0 = 0xff;
+
+        return l;
+    }
+
+    return NULL;
+}
+
+/*!
+    @brief    Composes the changes of the layers since the last update and refreshes the display.
+    The damage is the union of the old and new areas of every layer that moved, changed blend
+    mode, mask or visibility, and of the regions reported with PCD8544_layer_damage(). For each
+    damaged bank, only the damaged columns are composed from white, through all the visible
+    layers from the bottom to the top, into the display buffer and sent. The draw target, clip
+    rectangles, raster operation and pattern of the application do not apply and are restored afterwards.
+    An overlay that comes and goes leaves the layers under it untouched.
+    @param    comp   The compositor
+    @return          Success(True) or Failure(False) in composing and sending the data. The damage
+                     that could not be composed or sent is kept for the next update.
+*/
+bool PCD8544_compositor_update(pcd_8544_compositor_t *comp)
+{
+    /* Find the damage */
+    for(uint8_t i = 0; i < PCD8544_LAYER_MAX; i++)
+    {
+        pcd_8544_layer_t *l = &comp->layers[i];
+        if(!l->used) continue;
+
+        if(l->visible != l->drawn_visible || (l->visible && (l->x != l->drawn_x || l->y != l->drawn_y ||
+           l->blend != l->drawn_blend || l->mask != l->drawn_mask)))
+        {
+            if(l->drawn_visible) _add_layer_damage(comp, l, l->drawn_x, l->drawn_y);
+            if(l->visible) _add_layer_damage(comp, l, l->x, l->y);
+
+            l->drawn_x = l->x;
+            l->drawn_y = l->y;
+            l->drawn_blend = l->blend;
+            l->drawn_mask = l->mask;
+            l->drawn_visible = l->visible;
+        }
+
+        /* Changes of hidden layers do not show */
+        if(l->visible && l->damage_x0 <= l->damage_x1)
+            PCD8544_damage_add(&comp->damage, l->x + l->damage_x0, l->x + l->damage_x1, l->y + l->damage_y0, l->y + l->damage_y1);
+
+        l->damage_x0 = 0xff;
+        l->damage_x1 = 0;
+    }
+
+    return PCD8544_damage_flush(&comp->damage, _compose, comp);
+}
+
+/**********************************************************/
+/************************* LAYERS *************************/
+/**********************************************************/
+
+/*!
+    @brief    Moves a layer.
+    @param    layer    The layer
+    @param    x        The new x-coordinate, can be partially off-screen
+    @param    y        The new y-coordinate, can be partially off-screen
+*/
+void PCD8544_layer_move(pcd_8544_layer_t *layer, int16_t x, int16_t y)
+{
+    layer->x = x;
+    layer->y = y;
+}
+
+/*!
+    @brief    Shows or hides a layer.
+    @param    layer    The layer
+    @param    visible  Show(True) or hide(False) the layer
+*/
+void PCD8544_layer_show(pcd_8544_layer_t *layer, bool visible)
+{
+    layer->visible = visible;
+}
+
+/*!
+    @brief    Sets the blend mode of a layer.
+    @param    layer    The layer
+    @param    blend    The blend mode (PCD8544_BLEND_OR, _AND, _XOR or _REPLACE)
+    @param    mask     The mask of PCD8544_BLEND_REPLACE, a bitmap with the surface's size, NULL for
+                       the whole layer. Only surfaces with a stride equal to their width can be masked.
+    @return            Success(True) or Failure(False) on invalid arguments.
+*/
+bool PCD8544_layer_blend(pcd_8544_layer_t *layer, uint8_t blend, const uint8_t *mask)
+{
+    if(blend > PCD8544_BLEND_REPLACE) return false;
+    if(mask && (blend != PCD8544_BLEND_REPLACE || layer->surface->stride != layer->surface->width)) return false;
+
+    layer->blend = blend;
+    layer->mask = mask;
+
+    return true;
+}
+
+/*!
+    @brief    Marks a region of a layer's surface as changed, after drawing on it.
+    It is composed and refreshed at the next update, if the layer is visible.
+    @param    layer  The layer
+    @param    x0     Left-most x-coordinate, in the surface
+    @param    x1     Right-most x-coordinate, in the surface
+    @param    y0     Uppermost y-coordinate, in the surface
+    @param    y1     Lowermost y-coordinate, in the surface
+*/
+void PCD8544_layer_damage(pcd_8544_layer_t *layer, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    if(x0 > x1) { uint8_t t = x0; x0 = x1; x1 = t; }
+    if(y0 > y1) { uint8_t t = y0; y0 = y1; y1 = t; }
+
+    if(layer->damage_x0 > layer->damage_x1)
+    {
+        layer->damage_x0 = x0;
+        layer->damage_x1 = x1;
+        layer->damage_y0 = y0;
+        layer->damage_y1 = y1;
+        return;
+    }
+
+    if(x0 < layer->damage_x0) layer->damage_x0 = x0;
+    if(x1 > layer->damage_x1) layer->damage_x1 = x1;
+    if(y0 < layer->damage_y0) layer->damage_y0 = y0;
+    if(y1 > layer->damage_y1) layer->damage_y1 = y1;
+}
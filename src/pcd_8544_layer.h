@@ -0,0 +1,67 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_LAYER_H
+#define __PCD_8544_LAYER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes */
+#include <pcd_8544_damage.h>
+
+/* Compositor parameters */
+#define PCD8544_LAYER_MAX           4                           /* Number of layers in a compositor */
+
+/* Blend modes - How a layer is combined with the layers under it */
+#define PCD8544_BLEND_OR            0x00        /* Black pixels are drawn, white are transparent */
+#define PCD8544_BLEND_AND           0x01        /* White pixels are drawn, black are transparent */
+#define PCD8544_BLEND_XOR           0x02        /* Black pixels invert the layers under them */
+#define PCD8544_BLEND_REPLACE       0x03        /* Replaces the layers under it where the mask is set, or everywhere */
+
+/* Layer - A surface placed on the screen at an offset */
+typedef struct pcd_8544_layer_struct
+{
+    const pcd_8544_surface_t *surface;
+    const uint8_t *mask;                /* Mask of PCD8544_BLEND_REPLACE, a bitmap with the surface's size. NULL for the whole layer. */
+    int16_t x, y;                       /* Position of the surface, can be partially off-screen */
+    uint8_t blend;
+    bool visible, used;
+
+    /* Changed region of the surface since the last update, x0 > x1 if none */
+    uint8_t damage_x0, damage_x1, damage_y0, damage_y1;
+
+    /* State at the last update - Used for damage tracking */
+    int16_t drawn_x, drawn_y;
+    const uint8_t *drawn_mask;
+    uint8_t drawn_blend;
+    bool drawn_visible;
+}pcd_8544_layer_t;
+
+/* Compositor - Layers are combined from the first (bottom) to the last (top) over white */
+typedef struct pcd_8544_compositor_struct
+{
+    pcd_8544_layer_t layers[PCD8544_LAYER_MAX];
+    pcd_8544_damage_t damage;
+}pcd_8544_compositor_t;
+
+/* Compositor */
+void PCD8544_compositor_init(pcd_8544_compositor_t *comp);
+pcd_8544_layer_t *PCD8544_layer_add(pcd_8544_compositor_t *comp, const pcd_8544_surface_t *surface, uint8_t blend);
+bool PCD8544_compositor_update(pcd_8544_compositor_t *comp);
+
+/* Layer state */
+void PCD8544_layer_move(pcd_8544_layer_t *layer, int16_t x, int16_t y);
+void PCD8544_layer_show(pcd_8544_layer_t *layer, bool visible);
+bool PCD8544_layer_blend(pcd_8544_layer_t *layer, uint8_t blend, const uint8_t *mask);
+void PCD8544_layer_damage(pcd_8544_layer_t *layer, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_LAYER_H */
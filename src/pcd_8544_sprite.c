@@ -0,0 +1,254 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+#include <pcd_8544_sprite.h>    /* External header */
+
+#include <string.h>             /* For memset */
+
+/* Screen size and parameters */
+#define LCDWIDTH            PCD8544_WIDTH
+#define LCDHEIGHT           PCD8544_HEIGHT
+
+/* What a bank redraw needs - The pool and its visible sprites in z-order */
+typedef struct
+{
+    const pcd_8544_sprite_pool_t *pool;
+    uint8_t order[PCD8544_SPRITE_POOL];
+    uint8_t num;
+}_redraw_t;
+
+/**********************************************************/
+/************************ INTERNAL ************************/
+/**********************************************************/
+
+/*!
+    @brief    Marks the bounding box of a sprite as damaged. Internal routine.
+    @param    pool   The sprite pool
+    @param    x      Sprite x-coordinate
+    @param    y      Sprite y-coordinate
+    @param    s      The sprite, for its size
+*/
+static void _add_sprite_damage(pcd_8544_sprite_pool_t *pool, int16_t x, int16_t y, const pcd_8544_sprite_t *s)
+{
+    PCD8544_damage_add(&pool->damage, x, x + s->len_x - 1, y, y + s->len_y - 1);
+}
+
+/*!
+    @brief    Sorts the visible sprites by z-order, stable for equal z. Internal routine.
+    @param    pool   The sprite pool
+    @param    order  Output array with the sprite indices
+    @return          The number of visible sprites
+*/
+static uint8_t _sort_sprites(const pcd_8544_sprite_pool_t *pool, uint8_t *order)
+{
+    uint8_t num = 0;
+
+    for(uint8_t i = 0; i < PCD8544_SPRITE_POOL; i++)
+    {
+        const pcd_8544_sprite_t *s = &pool->sprites[i];
+        if(!s->used || !s->visible) continue;
+
+        /* Insertion sort - The pool is small */
+        uint8_t j = num++;
+        for(; j && pool->sprites[order[j - 1]].z > s->z; j--) order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    return num;
+}
+
+/*!
+    @brief    Draws the background and the sprites over a damaged bank, from the bottom to the top. Internal routine.
+    @param    ctx    The pool and its sprites in z-order (_redraw_t)
+    @param    x0     Left-most damaged column
+    @param    x1     Right-most damaged column
+    @param    y0     Uppermost row of the bank
+    @param    y1     Lowermost row of the bank
+*/
+static void _redraw(void *ctx, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    const _redraw_t *r = ctx;
+    const pcd_8544_sprite_pool_t *pool = r->pool;
+
+    if(pool->background) PCD8544_draw_bitmap_opt8(pool->background, 0, 0, LCDWIDTH, LCDHEIGHT);
+    else PCD8544_draw_rectangle(x0, x1, y0, y1, false, true);
+
+    for(uint8_t i = 0; i < r->num; i++)
+    {
+        const pcd_8544_sprite_t *s = &pool->sprites[r->order[i]];
+        const uint8_t *mask = s->masks ? s->masks[s->frame] : NULL;
+
+        if(mask) PCD8544_draw_sprite_s(s->frames[s->frame], mask, s->x, s->y, s->len_x, s->len_y);
+        else PCD8544_draw_sprite_key_s(s->frames[s->frame], s->x, s->y, s->len_x, s->len_y, false);
+    }
+}
+
+/**********************************************************/
+/************************* POOL ***************************/
+/**********************************************************/
+
+/*!
+    @brief    Initializes a sprite pool. The whole screen is marked as damaged, so the
+    first update draws the background everywhere.
+    @param    pool         The sprite pool
+    @param    background   Full screen bitmap, drawn under the sprites. NULL for white.
+*/
+void PCD8544_sprite_init(pcd_8544_sprite_pool_t *pool, const uint8_t *background)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->background = background;
+
+    PCD8544_damage_clear(&pool->damage);
+    PCD8544_sprite_invalidate(pool, 0, LCDWIDTH - 1, 0, LCDHEIGHT - 1);
+}
+
+/*!
+    @brief    Adds a sprite to the pool. The sprite starts visible at (0, 0) with the first frame.
+    @param    pool         The sprite pool
+    @param    frames       The frame table
+    @param    masks        The mask table (one mask per frame), NULL if white pixels are transparent
+    @param    num_frames   The number of frames
+    @param    len_x        The sprite width
+    @param    len_y        The sprite height
+    @param    z            The z-order, higher is drawn on top
+    @return                The sprite, or NULL if the pool is full or the arguments are invalid
+*/
+pcd_8544_sprite_t *PCD8544_sprite_add(pcd_8544_sprite_pool_t *pool, const uint8_t * const *frames, const uint8_t * const *masks,
+                                      uint8_t num_frames, uint8_t len_x, uint8_t len_y, uint8_t z)
+{
+    if(!frames || !num_frames || !len_x || !len_y) return NULL;
+
+    for(uint8_t i = 0; i < PCD8544_SPRITE_POOL; i++)
+    {
+        pcd_8544_sprite_t *s = &pool->sprites[i];
+
+        /* Slots of removed sprites are reused once their old position is restored */
+        if(s->used || s->drawn_visible) continue;
+
+        memset(s, 0, sizeof(*s));
+        s->frames = frames;
+        s->masks = masks;
+        s->num_frames = num_frames;
+        s->len_x = len_x;
+        s->len_y = len_y;
+        s->z = z;
+        s->visible = s->used = true;
+
+        return s;
+    }
+
+    return NULL;
+}
+
+/*!
+    @brief    Removes a sprite from the pool. Its area is restored at the next update.
+    @param    sprite   The sprite
+*/
+void PCD8544_sprite_remove(pcd_8544_sprite_t *sprite)
+{
+    sprite->used = sprite->visible = false;
+}
+
+/*!
+    @brief    Marks a region as damaged, e.g. after changing the background.
+    It is redrawn and refreshed at the next update.
+    @param    pool   The sprite pool
+    @param    x0     Left-most x-coordinate
+    @param    x1     Right-most x-coordinate
+    @param    y0     Uppermost y-coordinate
+    @param    y1     Lowermost y-coordinate
+*/
+void PCD8544_sprite_invalidate(pcd_8544_sprite_pool_t *pool, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    if(x0 > x1) { uint8_t t = x0; x0 = x1; x1 = t; }
+    if(y0 > y1) { uint8_t t = y0; y0 = y1; y1 = t; }
+
+    PCD8544_damage_add(&pool->damage, x0, x1, y0, y1);
+}
+
+/*!
+    @brief    Draws the changes of the sprites since the last update and refreshes the display.
+    The damage is the union of the old and new bounding boxes of every sprite that moved,
+    changed frame, z-order or visibility. For each damaged bank, only the damaged columns
+    are restored from the background, all the sprites are drawn over them (clipped) in
+    z-order and then sent to the display. Static content must be part of the background.
+    The sprites are drawn in the display buffer, over the whole screen, whatever the draw target,
+    clip rectangles, raster operation and pattern are, and those are restored afterwards.
+    @param    pool   The sprite pool
+    @return          Success(True) or Failure(False) in drawing and sending the data. The damage
+                     that could not be drawn is kept for the next update.
+*/
+bool PCD8544_sprite_update(pcd_8544_sprite_pool_t *pool)
+{
+    /* Find the damage */
+    for(uint8_t i = 0; i < PCD8544_SPRITE_POOL; i++)
+    {
+        pcd_8544_sprite_t *s = &pool->sprites[i];
+        bool visible = s->used && s->visible;
+
+        if(visible == s->drawn_visible && (!visible || (s->x == s->drawn_x && s->y == s->drawn_y &&
+           s->frame == s->drawn_frame && s->z == s->drawn_z))) continue;
+
+        if(s->drawn_visible) _add_sprite_damage(pool, s->drawn_x, s->drawn_y, s);
+        if(visible) _add_sprite_damage(pool, s->x, s->y, s);
+
+        s->drawn_x = s->x;
+        s->drawn_y = s->y;
+        s->drawn_frame = s->frame;
+        s->drawn_z = s->z;
+        s->drawn_visible = visible;
+    }
+
+    _redraw_t r;
+    r.pool = pool;
+    r.num = _sort_sprites(pool, r.order);
+
+    return PCD8544_damage_flush(&pool->damage, _redraw, &r);
+}
+
+/**********************************************************/
+/************************ SPRITES *************************/
+/**********************************************************/
+
+/*!
+    @brief    Moves a sprite.
+    @param    sprite   The sprite
+    @param    x        The new x-coordinate, can be partially off-screen
+    @param    y        The new y-coordinate, can be partially off-screen
+*/
+void PCD8544_sprite_move(pcd_8544_sprite_t *sprite, int16_t x, int16_t y)
+{
+    sprite->x = x;
+    sprite->y = y;
+}
+
+/*!
+    @brief    Sets the frame of a sprite.
+    @param    sprite   The sprite
+    @param    frame    The frame, wraps around the number of frames
+*/
+void PCD8544_sprite_frame(pcd_8544_sprite_t *sprite, uint8_t frame)
+{
+    sprite->frame = frame % sprite->num_frames;
+}
+
+/*!
+    @brief    Advances a sprite to its next animation frame, wrapping to the first one.
+    @param    sprite   The sprite
+*/
+void PCD8544_sprite_next_frame(pcd_8544_sprite_t *sprite)
+{
+    PCD8544_sprite_frame(sprite, sprite->frame + 1);
+}
+
+/*!
+    @brief    Shows or hides a sprite.
+    @param    sprite   The sprite
+    @param    visible  Show(True) or hide(False) the sprite
+*/
+void PCD8544_sprite_show(pcd_8544_sprite_t *sprite, bool visible)
+{
+    sprite->visible = visible;
+}
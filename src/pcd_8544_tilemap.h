@@ -0,0 +1,39 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/* Define to prevent recursive inclusion */
+#ifndef __PCD_8544_TILEMAP_H
+#define __PCD_8544_TILEMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes */
+#include <pcd_8544.h>
+
+/* Tile size - A tile is one bank tall, so it is 8 contiguous bytes (one per column) */
+#define PCD8544_TILE_SZ         8
+
+/* Tilemap - The map is a row-major array of tile indices into the atlas */
+typedef struct pcd_8544_tilemap_struct
+{
+    const uint8_t *atlas;           /* Tiles, PCD8544_TILE_SZ bytes each in the display's layout */
+    const uint8_t *map;             /* Tile indices, width * height */
+    uint8_t width, height;          /* Map size in tiles */
+    int16_t scroll_x, scroll_y;     /* Map pixel shown at the top left corner of the window */
+    bool wrap;                      /* Repeat the map at its edges, else the window is white outside of it */
+}pcd_8544_tilemap_t;
+
+/* Tilemaps */
+void PCD8544_tilemap_init(pcd_8544_tilemap_t *tm, const uint8_t *atlas, const uint8_t *map, uint8_t width, uint8_t height);
+void PCD8544_tilemap_scroll(pcd_8544_tilemap_t *tm, int16_t x, int16_t y);
+bool PCD8544_tilemap_draw(const pcd_8544_tilemap_t *tm, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCD_8544_TILEMAP_H */
@@ -0,0 +1,554 @@
+/*
+  * Author: Anastasis Vagenas
+  * Contact: anasvag29@gmail.com
+  */
+
+/*
+ * Host converter of PBM/PGM images to C arrays in the layout of PCD8544_draw_bitmap()
+ * and PCD8544_draw_bitmap_opt8() - Banks of 8 rows, one byte per column, LSB at the top.
+ *
+ * Build:   cc -O2 -DPCD8544_DITHER_HOST -I src -o pcd8544_conv tools/pcd8544_conv.c src/pcd_8544_dither.c src/pcd_8544_bayer.c
+ * Usage:   pcd8544_conv [options] image.pbm [image.pgm ...] > assets.h
+ *
+ * The arrays are printed on the standard output, the statistics of every asset on the standard error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>             /* For getopt */
+
+#include <pcd_8544_dither.h>    /* Same dithering as on the target, built with PCD8544_DITHER_HOST */
+
+/* Same packets as PCD8544_RLE_RUN of the library */
+#define RLE_RUN             0x80
+#define RLE_MAX_RUN         129
+#define RLE_MAX_LITERAL     128
+
+/* Limits of the drawing functions - The size is given as uint8_t */
+#define MAX_SIZE            255
+
+/* Greyscale images are only thresholded, at any level - Else one of PCD8544_DITHER_* */
+#define DITHER_NONE         0xff
+
+/* Conversion options */
+typedef struct conv_options_struct
+{
+    const char *name;           /* Array name, only with a single image */
+    uint8_t dither, threshold;
+    bool invert, crop, align, compress;
+}conv_options_t;
+
+/* Greyscale image, 0 is black and 255 is white */
+typedef struct image_struct
+{
+    int width, height;
+    uint8_t *grey;
+}image_t;
+
+/* Monochrome asset, in banks */
+typedef struct asset_struct
+{
+    int x, y;                   /* Position of the asset in the image, after cropping */
+    int width, height;          /* Size, after cropping and padding */
+    int banks;
+    uint8_t *data;              /* width * banks bytes */
+}asset_t;
+
+/**********************************************************/
+/************************* INPUT **************************/
+/**********************************************************/
+
+/*!
+    @brief    Reads the next number of a PNM header, skipping white space and comments.
+    @param    f      The file
+    @param    val    The number
+    @return          Success(True) or Failure(False).
+*/
+static bool _read_number(FILE *f, int *val)
+{
+    int c;
+
+    while((c = fgetc(f)) != EOF)
+    {
+        if(c == '#') while((c = fgetc(f)) != EOF && c != '\n');
+        else if(!isspace(c)) break;
+    }
+
+    if(!isdigit(c)) return false;
+
+    for(*val = 0; isdigit(c); c = fgetc(f)) *val = *val * 10 + (c - '0');
+
+    return true;
+}
+
+/*!
+    @brief    Reads a PBM (P1/P4) or PGM (P2/P5) image.
+    @param    path   The file path
+    @param    img    The image, allocated here
+    @return          Success(True) or Failure(False).
+*/
+static bool read_pnm(const char *path, image_t *img)
+{
+    FILE *f = fopen(path, "rb");
+    if(!f)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+
+    int format = 0, maxval = 1;
+    bool ok = fgetc(f) == 'P';
+    if(ok) format = fgetc(f) - '0';
+
+    ok = ok && (format == 1 || format == 2 || format == 4 || format == 5);
+    ok = ok && _read_number(f, &img->width) && _read_number(f, &img->height);
+    if(ok && (format == 2 || format == 5)) ok = _read_number(f, &maxval) && maxval > 0 && maxval < 65536;
+    ok = ok && img->width > 0 && img->height > 0;
+
+    if(!ok)
+    {
+        fprintf(stderr, "%s: not a PBM/PGM image\n", path);
+        fclose(f);
+        return false;
+    }
+
+    /* The single white space after the header was consumed by _read_number() */
+    img->grey = malloc((size_t)img->width * img->height);
+    if(!img->grey)
+    {
+        fclose(f);
+        return false;
+    }
+
+    for(int y = 0; y < img->height && ok; y++)
+    {
+        int bits = 0, acc = 0;
+
+        for(int x = 0; x < img->width && ok; x++)
+        {
+            int val = 0;
+
+            switch(format)
+            {
+                case 1:     /* 1 is black */
+                    do { val = fgetc(f); } while(val != EOF && val != '0' && val != '1');
+                    ok = (val != EOF);
+                    val = (val == '1') ? 0 : 255;
+                    break;
+
+                case 4:     /* Rows are padded to bytes, MSB first */
+                    if(!bits)
+                    {
+                        acc = fgetc(f);
+                        bits = 8;
+                        ok = (acc != EOF);
+                    }
+                    val = ((acc >> --bits) & 0x01) ? 0 : 255;
+                    break;
+
+                case 2:
+                    ok = _read_number(f, &val);
+                    val = val * 255 / maxval;
+                    break;
+
+                case 5:     /* 16-bit samples are big endian */
+                    val = fgetc(f);
+                    if(maxval > 255 && val != EOF)
+                    {
+                        int lo = fgetc(f);
+                        val = (lo == EOF) ? EOF : (val << 8) | lo;
+                    }
+                    ok = (val != EOF);
+                    val = val * 255 / maxval;
+                    break;
+            }
+
+            img->grey[y * img->width + x] = (val > 255) ? 255 : val;
+        }
+    }
+
+    fclose(f);
+
+    if(!ok)
+    {
+        fprintf(stderr, "%s: truncated image\n", path);
+        free(img->grey);
+    }
+
+    return ok;
+}
+
+/**********************************************************/
+/*********************** DITHERING ************************/
+/**********************************************************/
+
+/* Image being dithered - The dithering module draws its banks in it */
+static image_t *_dithered;
+
+/*!
+    @brief    Stores a bank of the dithering module in the image being dithered, black(0) and white(255).
+    The module draws its banks with this function, in place of the library's on the target.
+    @param    bitmap    The bank, a byte per column
+    @param    x0        Leftmost x-coordinate
+    @param    y0        Uppermost y-coordinate
+    @param    len_x     The width of the bank
+    @param    len_y     The rows of the bank
+*/
+void PCD8544_draw_bitmap_s(const uint8_t *bitmap, int16_t x0, int16_t y0, uint8_t len_x, uint8_t len_y)
+{
+    for(int y = 0; y < len_y; y++)
+    {
+        uint8_t *row = _dithered->grey + (size_t)(y0 + y) * _dithered->width + x0;
+        for(int x = 0; x < len_x; x++) row[x] = ((bitmap[x] >> y) & 0x01) ? 0 : 255;
+    }
+}
+
+/*!
+    @brief    Converts a greyscale image to black and white, in place (0 black, 255 white).
+    The dithering is pcd_8544_dither.c, row by row. Its rows are at most 255 pixels long,
+    so wider images are dithered in strips and the error does not cross from one to the next.
+    @param    img        The image
+    @param    dither     The dithering method
+    @param    threshold  The threshold without dithering, darker pixels are black
+    @return              Success(True) or Failure(False).
+*/
+static bool dither_image(image_t *img, uint8_t dither, uint8_t threshold)
+{
+    int w = img->width, h = img->height;
+
+    if(dither == DITHER_NONE)
+    {
+        for(size_t i = 0; i < (size_t)w * h; i++) img->grey[i] = (img->grey[i] < threshold) ? 0 : 255;
+        return true;
+    }
+
+    /* The rows of the stream start at an int16_t */
+    if(h > INT16_MAX)
+    {
+        fprintf(stderr, "images taller than %d rows cannot be dithered\n", INT16_MAX);
+        return false;
+    }
+
+    static int16_t error[PCD8544_DITHER_ERR_SZ(MAX_SIZE)];
+    static uint8_t bank[MAX_SIZE];
+    _dithered = img;
+
+    for(int x0 = 0; x0 < w; x0 += MAX_SIZE)
+    {
+        pcd_8544_dither_t d;
+        uint8_t len_x = (w - x0 < MAX_SIZE) ? w - x0 : MAX_SIZE;
+
+        if(!PCD8544_dither_init(&d, dither, x0, 0, len_x, error, bank)) return false;
+
+        for(int y = 0; y < h; y++) PCD8544_dither_rows(&d, img->grey + (size_t)y * w + x0, w, 1);
+        PCD8544_dither_end(&d);
+    }
+
+    return true;
+}
+
+/**********************************************************/
+/************************ ASSETS **************************/
+/**********************************************************/
+
+/*!
+    @brief    Checks if a pixel of a black and white image is black.
+    @param    img    The image
+    @param    x      The x-coordinate
+    @param    y      The y-coordinate
+    @param    invert Swap black and white
+    @return          Black(True) or White(False).
+*/
+static bool _black(const image_t *img, int x, int y, bool invert)
+{
+    return !img->grey[y * img->width + x] != invert;
+}
+
+/*!
+    @brief    Builds an asset out of a black and white image.
+    With cropping, only the bounding box of the black pixels is kept. With alignment,
+    the top of the box is moved up to a bank boundary and the height is padded to a
+    multiple of 8, so an asset drawn at its original position takes the opt8 path.
+    @param    img    The image
+    @param    opt    The options
+    @param    asset  The asset, allocated here
+    @return          Success(True) or Failure(False).
+*/
+static bool make_asset(const image_t *img, const conv_options_t *opt, asset_t *asset)
+{
+    int x0 = 0, x1 = img->width - 1, y0 = 0, y1 = img->height - 1;
+
+    if(opt->crop)
+    {
+        x0 = img->width; x1 = -1; y0 = img->height; y1 = -1;
+
+        for(int y = 0; y < img->height; y++)
+        {
+            for(int x = 0; x < img->width; x++)
+            {
+                if(!_black(img, x, y, opt->invert)) continue;
+                if(x < x0) x0 = x;
+                if(x > x1) x1 = x;
+                if(y < y0) y0 = y;
+                if(y > y1) y1 = y;
+            }
+        }
+
+        /* A blank image keeps a single pixel */
+        if(x1 < 0) x0 = x1 = y0 = y1 = 0;
+    }
+
+    if(opt->align)
+    {
+        y0 &= ~0x07;
+        y1 |= 0x07;
+    }
+
+    asset->x = x0;
+    asset->y = y0;
+    asset->width = x1 - x0 + 1;
+    asset->height = y1 - y0 + 1;
+    asset->banks = (asset->height + 7) / 8;
+
+    if(asset->width > MAX_SIZE || asset->height > MAX_SIZE)
+    {
+        fprintf(stderr, "asset of %dx%d is larger than %dx%d\n", asset->width, asset->height, MAX_SIZE, MAX_SIZE);
+        return false;
+    }
+
+    asset->data = calloc((size_t)asset->width * asset->banks, 1);
+    if(!asset->data) return false;
+
+    /* Rows past the image (padding) are white */
+    for(int y = y0; y <= y1 && y < img->height; y++)
+    {
+        for(int x = x0; x <= x1; x++)
+        {
+            if(_black(img, x, y, opt->invert)) asset->data[((y - y0) >> 3) * asset->width + (x - x0)] |= 1 << ((y - y0) & 0x07);
+        }
+    }
+
+    return true;
+}
+
+/*!
+    @brief    Run-length encodes the bank bytes of an asset, as PCD8544_draw_bitmap_rle() expects.
+    Runs of three or more equal bytes are stored as runs, everything else as literals, so the
+    output is never larger than the bytes plus a literal header for every 128 of them.
+    @param    data    The bytes
+    @param    len     The number of bytes
+    @param    out     The encoded bytes, at least len + len / 128 + 1 bytes
+    @param    packets The number of packets
+    @return           The size of the encoded bytes.
+*/
+static size_t rle_encode(const uint8_t *data, size_t len, uint8_t *out, size_t *packets)
+{
+    size_t k = 0;
+    *packets = 0;
+
+    for(size_t i = 0; i < len; (*packets)++)
+    {
+        size_t run = 1;
+        while(i + run < len && run < RLE_MAX_RUN && data[i + run] == data[i]) run++;
+
+        if(run >= 3)
+        {
+            out[k++] = RLE_RUN | (run - 2);
+            out[k++] = data[i];
+            i += run;
+            continue;
+        }
+
+        /* Literals end before the next three equal bytes, which are cheaper as a run */
+        size_t start = i, n = 0;
+        for(; i < len && n < RLE_MAX_LITERAL && !(i + 2 < len && data[i + 1] == data[i] && data[i + 2] == data[i]); i++) n++;
+
+        out[k++] = n - 1;
+        memcpy(out + k, data + start, n);
+        k += n;
+    }
+
+    return k;
+}
+
+/**********************************************************/
+/************************ OUTPUT **************************/
+/**********************************************************/
+
+/*!
+    @brief    Makes a C identifier out of a file path, e.g. "img/Logo-1.pbm" to "logo_1".
+    @param    path   The file path
+    @param    name   The identifier
+    @param    sz     The size of name
+*/
+static void _make_name(const char *path, char *name, size_t sz)
+{
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+
+    size_t k = 0;
+    if(isdigit((unsigned char)*base) && k + 1 < sz) name[k++] = '_';
+
+    for(; *base && *base != '.' && k + 1 < sz; base++) name[k++] = isalnum((unsigned char)*base) ? tolower((unsigned char)*base) : '_';
+    name[k] = '\0';
+}
+
+/*!
+    @brief    Prints a byte array, 16 bytes per line.
+    @param    name   The array name
+    @param    data   The bytes
+    @param    len    The number of bytes
+*/
+static void _print_array(const char *name, const uint8_t *data, size_t len)
+{
+    printf("const uint8_t %s[%zu] =\n{\n", name, len);
+
+    for(size_t i = 0; i < len; i++)
+    {
+        printf("%s0x%02X,%s", (i % 16) ? " " : "    ", data[i], (i % 16 == 15 || i == len - 1) ? "\n" : "");
+    }
+
+    printf("};\n\n");
+}
+
+/*!
+    @brief    Prints an asset as C code and its statistics.
+    The cost of a draw is given in bank bytes written: an asset drawn at a bank boundary
+    writes width bytes per bank, anywhere else it is shifted over one more bank.
+    @param    path   The source image, for the statistics
+    @param    name   The array name
+    @param    asset  The asset
+    @param    opt    The options
+*/
+static void print_asset(const char *path, const char *name, const asset_t *asset, const conv_options_t *opt)
+{
+    char upper[64];
+    size_t raw = (size_t)asset->width * asset->banks, packets = 0, rle_sz = 0;
+    bool opt8 = !(asset->height & 0x07);
+
+    for(size_t i = 0; i < sizeof(upper) && (!i || name[i - 1]); i++) upper[i] = toupper((unsigned char)name[i]);
+    upper[sizeof(upper) - 1] = '\0';
+
+    printf("/* %s - %dx%d", path, asset->width, asset->height);
+    if(opt->crop) printf(", cropped at (%d, %d)", asset->x, asset->y);
+    printf(" */\n");
+    printf("#define %s_WIDTH %d\n#define %s_HEIGHT %d\n", upper, asset->width, upper, asset->height);
+    if(opt->crop) printf("#define %s_X %d\n#define %s_Y %d\n", upper, asset->x, upper, asset->y);
+    printf("\n");
+
+    uint8_t *rle = malloc(raw + raw / RLE_MAX_LITERAL + 1);
+    if(rle) rle_sz = rle_encode(asset->data, raw, rle, &packets);
+
+    if(opt->compress && rle)
+    {
+        char rle_name[80];
+        snprintf(rle_name, sizeof(rle_name), "%s_rle", name);
+        printf("/* PCD8544_draw_bitmap_rle(%s, x, y, %s_WIDTH, %s_HEIGHT) */\n", rle_name, upper, upper);
+        _print_array(rle_name, rle, rle_sz);
+    }
+    else
+    {
+        printf("/* PCD8544_draw_bitmap%s(%s, x, y, %s_WIDTH, %s_HEIGHT) */\n", opt8 ? "_opt8" : "", name, upper, upper);
+        _print_array(name, asset->data, raw);
+    }
+
+    fprintf(stderr, "%s: %s %dx%d", path, name, asset->width, asset->height);
+    if(opt->crop) fprintf(stderr, " at (%d, %d)", asset->x, asset->y);
+    fprintf(stderr, "\n\traw %zu bytes, rle %zu bytes in %zu packets (%.0f%%)%s\n", raw, rle_sz, packets,
+            raw ? 100.0 * rle_sz / raw : 0.0, opt->compress ? " - stored" : "");
+    fprintf(stderr, "\tdraw cost: %zu bank bytes at y %% 8 == 0, %zu elsewhere%s\n", raw, raw + asset->width,
+            opt8 ? " - opt8 ready" : " - height not a multiple of 8, use -a for opt8");
+
+    free(rle);
+}
+
+/**********************************************************/
+/************************** MAIN **************************/
+/**********************************************************/
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [options] image.pbm|image.pgm ...\n"
+        "  -n name       array name (single image), default from the file name\n"
+        "  -t level      threshold of greyscale images without dithering, 0-255 (default 128)\n"
+        "  -d method     dithering of greyscale images: none, fs, atkinson, bayer\n"
+        "  -i            invert, white pixels are drawn\n"
+        "  -c            crop to the bounding box of the black pixels\n"
+        "  -a            align to banks, the height is padded to a multiple of 8 (opt8)\n"
+        "  -z            compress, for PCD8544_draw_bitmap_rle()\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    conv_options_t opt = { .name = NULL, .dither = DITHER_NONE, .threshold = 128 };
+    int c;
+
+    while((c = getopt(argc, argv, "n:t:d:icazh")) != -1)
+    {
+        switch(c)
+        {
+            case 'n': opt.name = optarg; break;
+            case 't': opt.threshold = (uint8_t)atoi(optarg); break;
+            case 'i': opt.invert = true; break;
+            case 'c': opt.crop = true; break;
+            case 'a': opt.align = true; break;
+            case 'z': opt.compress = true; break;
+            case 'd':
+                if(!strcmp(optarg, "none")) opt.dither = DITHER_NONE;
+                else if(!strcmp(optarg, "fs")) opt.dither = PCD8544_DITHER_FS;
+                else if(!strcmp(optarg, "atkinson")) opt.dither = PCD8544_DITHER_ATKINSON;
+                else if(!strcmp(optarg, "bayer")) opt.dither = PCD8544_DITHER_BAYER;
+                else
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind >= argc || (opt.name && argc - optind > 1))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("/* Generated by pcd8544_conv - Banks of 8 rows, one byte per column, LSB at the top */\n\n");
+
+    int ret = 0;
+    for(int i = optind; i < argc; i++)
+    {
+        image_t img;
+        asset_t asset;
+        char name[64];
+
+        if(!read_pnm(argv[i], &img))
+        {
+            ret = 1;
+            continue;
+        }
+
+        if(opt.name) snprintf(name, sizeof(name), "%s", opt.name);
+        else _make_name(argv[i], name, sizeof(name));
+
+        /* PBM images are already black and white, dithering them changes nothing */
+        if(dither_image(&img, opt.dither, opt.threshold) && make_asset(&img, &opt, &asset))
+        {
+            print_asset(argv[i], name, &asset, &opt);
+            free(asset.data);
+        }
+        else ret = 1;
+
+        free(img.grey);
+    }
+
+    return ret;
+}